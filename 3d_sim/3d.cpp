@@ -8,12 +8,37 @@
 #include "Droplet.h"
 #include "ShaderUtils.h"
 #include "Particle.h"
+#include "Simulation.h"
+#include "DomainDecomposition.h"
+#include "Replay.h"
+#include "StreamServer.h"
+#include "StreamClient.h"
+#include "SimulationThread.h"
+#include "MemoryMonitor.h"
+#include "RainGauge.h"
+#include "QualityGovernor.h"
+#include "GpuTimer.h"
+#include "Skybox.h"
+#include "RainStreaks.h"
+#include "ShadowMap.h"
+#include "SplashRing.h"
 #include <vector>
 #include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 
 // Window dimensions
 const GLuint WIDTH = 800, HEIGHT = 600;
 
+// A puddle is its drop's mesh squashed to a disc, PUDDLE_SPREAD times as
+// wide, lifted just clear of the ground so the two don't z-fight
+const float PUDDLE_SPREAD = 3.0f;
+const float PUDDLE_FLATTEN = 0.05f;
+const float PUDDLE_LIFT = 0.003f;
+
 // Global variables for camera
 glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 5.0f);
 glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
@@ -22,7 +47,6 @@ glm::vec3 lightPos2 = glm::vec3(-3.0f, 4.0f, -2.0f);
 float yaw = -90.0f, pitch = 0.0f, zoom = 45.0f;
 float lastX = WIDTH / 2.0f, lastY = HEIGHT / 2.0f;
 bool firstMouse = true;
-std::vector<Particle> particles;
 
 // Mouse callback
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -156,15 +180,155 @@ void createDroplet(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices,
     }
 }
 
-// load shader source code
-std::string vertexCode = loadShaderSource("vertex_shader.glsl");
-std::string fragmentCode = loadShaderSource("fragment_shader.glsl");
+// Camera, lights and colours shared by every program that uses fragment_shader.glsl
+void setSceneUniforms(GLuint program, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& lightPos) {
+    glUniform3fv(glGetUniformLocation(program, "lightPos2"), 1, glm::value_ptr(lightPos2));
+    glUniform3fv(glGetUniformLocation(program, "lightPos"), 1, glm::value_ptr(lightPos));
+    glUniform3fv(glGetUniformLocation(program, "viewPos"), 1, glm::value_ptr(cameraPos));
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+
+    glm::vec3 waterColor = glm::vec3(0.2f, 0.5f, 0.8f); // More natural blue color for water
+    glUniform3fv(glGetUniformLocation(program, "dropletColor"), 1, glm::value_ptr(waterColor)); // Blue color for the droplets
 
-const char* vertexShaderSource = vertexCode.c_str();
-const char* fragmentShaderSource = fragmentCode.c_str();
+    glm::vec3 groundColor = glm::vec3(0.7f, 0.65f, 0.5f); // Sandy brown
+    glUniform3fv(glGetUniformLocation(program, "groundColor"), 1, glm::value_ptr(groundColor));
+}
 
-int main() {
-    bool isPaused = false;
+int main(int argc, char** argv) {
+    // Rain over the +-5 m patch around the origin
+    Simulation sim(glm::vec2(-5.0f), glm::vec2(5.0f));
+
+    // Headless tiled mode, see DomainDecomposition.h
+    DomainConfig domain;
+    bool tiled = false;
+
+    // Headless deterministic run, see Replay.h
+    ReplayConfig replay;
+    bool replaying = false;
+
+    // Headless server for remote viewers, or a viewer of one, see StreamServer.h
+    StreamConfig stream;
+    bool serving = false;
+    std::string viewAddress;
+
+    // Ground impact time series over the starting region, see RainGauge.h
+    std::string gaugePrefix;
+    bool gaugeBinary = false;
+    float gaugeCell = 0.5f;
+    int gaugeInterval = 60;
+
+    // Per-step allocation and store-size reports, see MemoryMonitor.h
+    bool allocStats = false;
+
+    // Frame time the quality governor aims for (0 leaves quality alone)
+    float frameBudgetMs = 16.6f;
+
+    // The simulated region follows the camera, with streaks drawn beyond it
+    bool followCamera = true;
+
+    // Side of the rain shadow map in texels (0 turns shadows off). Kept
+    // below the 800x600 window so the extra pass costs less than the main
+    // one. GPU splashes (--gpu-splashes) only exist in the vertex shader,
+    // never in the snapshot, so they cast no shadows
+    int shadowSize = 512;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--wind") == 0 && i + 1 < argc) {
+            sim.wind.loadFromFile(argv[++i]);
+        } else if (std::strcmp(argv[i], "--gpu-splashes") == 0) {
+            sim.gpuSplashes = true;
+        } else if (std::strcmp(argv[i], "--compact") == 0) {
+            sim.compactParticles = true;
+            replay.compactParticles = true;
+        } else if (std::strcmp(argv[i], "--tiles") == 0 && i + 1 < argc) {
+            tiled = std::sscanf(argv[++i], "%dx%d", &domain.tilesX, &domain.tilesZ) == 2;
+            if (!tiled) {
+                std::cerr << "--tiles expects NxM, e.g. 4x4" << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--tile-size") == 0 && i + 1 < argc) {
+            domain.tileSize = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            domain.steps = replay.steps = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--rain-rate") == 0 && i + 1 < argc) {
+            domain.rainRate = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--transport") == 0 && i + 1 < argc) {
+            domain.useSockets = std::strcmp(argv[++i], "socket") == 0;
+        } else if (std::strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc) {
+            frameBudgetMs = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            serving = true;
+            stream.address = argv[++i];
+        } else if (std::strcmp(argv[i], "--connect") == 0 && i + 1 < argc) {
+            viewAddress = argv[++i];
+        } else if (std::strcmp(argv[i], "--fixed-region") == 0) {
+            followCamera = false;
+        } else if (std::strcmp(argv[i], "--shadow-size") == 0 && i + 1 < argc) {
+            shadowSize = std::max(std::atoi(argv[++i]), 0);
+        } else if (std::strcmp(argv[i], "--gauge") == 0 && i + 1 < argc) {
+            gaugePrefix = argv[++i];
+        } else if (std::strcmp(argv[i], "--gauge-format") == 0 && i + 1 < argc) {
+            gaugeBinary = std::strcmp(argv[++i], "bin") == 0;
+        } else if (std::strcmp(argv[i], "--gauge-cell") == 0 && i + 1 < argc) {
+            gaugeCell = std::max(static_cast<float>(std::atof(argv[++i])), 0.01f);
+        } else if (std::strcmp(argv[i], "--gauge-interval") == 0 && i + 1 < argc) {
+            gaugeInterval = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--alloc-stats") == 0) {
+            allocStats = replay.allocStats = true;
+        } else if (std::strcmp(argv[i], "--replay") == 0) {
+            replaying = true;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            replay.seed = static_cast<uint32_t>(std::strtoul(argv[++i], NULL, 10));
+        } else if (std::strcmp(argv[i], "--dt") == 0 && i + 1 < argc) {
+            replay.timestep = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            replay.checkpointInterval = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            replay.tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            replay.comparePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            replay.tolerance = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            replay.goldenDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--record-golden") == 0) {
+            replay.recordGolden = true;
+        }
+    }
+
+    if (tiled) {
+        return runDomainDecomposition(domain);
+    }
+    if (replaying) {
+        return runReplay(replay);
+    }
+
+    // The gauge stays put in world space even when the region follows the camera
+    glm::vec2 gaugeSize = sim.regionMax - sim.regionMin;
+    RainGauge gauge(sim.regionMin, gaugeCell, static_cast<int>(std::ceil(gaugeSize.x / gaugeCell)),
+                    static_cast<int>(std::ceil(gaugeSize.y / gaugeCell)));
+    if (!gaugePrefix.empty()) {
+        if (!gauge.open(gaugePrefix, gaugeBinary, gaugeInterval)) {
+            return -1;
+        }
+        sim.gauge = &gauge;
+    }
+
+    if (serving) {
+        return runStreamServer(sim, stream);
+    }
+
+    // A viewer draws the server's fixed region and never steps sim itself
+    StreamClient viewer;
+    bool viewing = !viewAddress.empty();
+    if (viewing) {
+        if (!viewer.connect(viewAddress)) {
+            return -1;
+        }
+        followCamera = false;
+        sim.gpuSplashes = false;
+    }
 
     // Initialize GLFW
     if (!glfwInit()) {
@@ -204,33 +368,64 @@ int main() {
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
     
-    // Create and compile shaders
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-    
-    // Create shader program
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    
-    // Check for linking errors
-    GLint success;
-    GLchar infoLog[512];
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    // Shaders are embedded in the binary; linked programs come from the
+    // on-disk binary cache when this driver has seen them before
+    GLuint shaderProgram = createProgram(shaderSource("vertex_shader.glsl").c_str(),
+                                         shaderSource("fragment_shader.glsl").c_str());
+    if (!shaderProgram) {
         return -1;
     }
+
+    // Sky faces decode in the background; until they arrive the clear colour shows
+    glm::vec3 clearColor = glm::vec3(0.2f, 0.2f, 0.2f);
+    Skybox skybox;
+    if (skybox.init(shaderSource("skybox_vertex.glsl").c_str(), shaderSource("skybox_fragment.glsl").c_str(), clearColor)) {
+        skybox.startLoading("textures/skybox", "textures/skybox/skybox.cache");
+    }
     
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // Far-field rain past the simulated region, faded in where its drops fade out
+    RainStreaks streaks;
+    if (followCamera && !streaks.init(shaderSource("streak_vertex.glsl").c_str(),
+                                      shaderSource("streak_fragment.glsl").c_str())) {
+        return -1;
+    }
+    float simRadius = 0.5f * std::min(sim.regionMax.x - sim.regionMin.x, sim.regionMax.y - sim.regionMin.y);
+    streaks.innerRadius = simRadius;
+    streaks.groundHeight = sim.groundHeight;
+    streaks.ceiling = sim.spawnHeight;
+    streaks.wind = sim.wind.prevailing;
+
+    // Light position
+    glm::vec3 lightPos = glm::vec3(2.0f, 3.0f, 2.0f);
+
+    // The rain's shadow on the ground, cast as if the main light were distant
+    ShadowMap shadows(shadowSize);
+    if (shadowSize > 0 && !shadows.init(shaderSource("shadow_vertex.glsl").c_str(),
+                                        shaderSource("shadow_fragment.glsl").c_str())) {
+        return -1;
+    }
+    shadows.lightDirection = lightPos - glm::vec3(0.0f, sim.groundHeight, 0.0f);
+    shadows.radius = simRadius;
+    shadows.groundHeight = sim.groundHeight;
+    shadows.ceiling = sim.spawnHeight;
+    shadows.dropRadius = 0.1f; // createDroplet's radius below
+    glm::vec2 regionCentre = 0.5f * (sim.regionMin + sim.regionMax);
     
     // Create sphere mesh for water droplet
     std::vector<GLfloat> sphereVertices;
     std::vector<GLuint> sphereIndices;
-    createDroplet(sphereVertices, sphereIndices, 0.1f, 32, 16);
+    {
+        ALLOC_SCOPE(ALLOC_MESH);
+        AllocCounts before = threadAllocCounts();
+        createDroplet(sphereVertices, sphereIndices, 0.1f, 32, 16);
+        if (allocStats && allocStatsEnabled()) {
+            AllocCounts after = threadAllocCounts();
+            std::cout << "droplet mesh: " << after.count[ALLOC_MESH] - before.count[ALLOC_MESH] << " allocations, "
+                      << after.bytes[ALLOC_MESH] - before.bytes[ALLOC_MESH] << " bytes for "
+                      << sphereVertices.capacity() * sizeof(GLfloat) + sphereIndices.capacity() * sizeof(GLuint)
+                      << " bytes of capacity" << std::endl;
+        }
+    }
     
     // Create VAO, VBO, EBO
     GLuint VAO, VBO, EBO;
@@ -255,6 +450,28 @@ int main() {
     glEnableVertexAttribArray(1);
     
     glBindVertexArray(0);
+
+    // Low-poly droplet (8x4 instead of 32x16) for drops and particles past the
+    // quality governor's LOD distance
+    std::vector<GLfloat> lowVertices;
+    std::vector<GLuint> lowIndices;
+    createDroplet(lowVertices, lowIndices, 0.1f, 8, 4);
+
+    GLuint lowVAO, lowVBO, lowEBO;
+    glGenVertexArrays(1, &lowVAO);
+    glGenBuffers(1, &lowVBO);
+    glGenBuffers(1, &lowEBO);
+
+    glBindVertexArray(lowVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, lowVBO);
+    glBufferData(GL_ARRAY_BUFFER, lowVertices.size() * sizeof(GLfloat), lowVertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lowEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, lowIndices.size() * sizeof(GLuint), lowIndices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
     
     // Create a ground plane VAO
     GLfloat groundVertices[] = {
@@ -309,9 +526,6 @@ int main() {
     
     glBindVertexArray(0);
 
-    std::vector<Droplet> droplets;
-    float spawnTimer = 0.0f;
-
     // Store initial state of droplet
     // glm::vec3 initialPosition = glm::vec3(0.0f, 2.0f, 0.0f);
     // glm::vec3 initialVelocity = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -319,19 +533,38 @@ int main() {
 
     // Create a droplet
     // Droplet droplet(initialPosition, initialVelocity, initialSize);
+
+    // Splash particles drawn straight from their birth state on the GPU
+    // (--gpu-splashes); 256K slots covers a few seconds of heavy rain
+    SplashRing splashes(1 << 18);
+    std::vector<SplashSpawn> newSplashes;
+    float lastSplashTime = 0.0f;
+    if (sim.gpuSplashes && !splashes.init(shaderSource("splash_vertex.glsl").c_str(),
+                                          shaderSource("fragment_shader.glsl").c_str(),
+                                          VBO, EBO, static_cast<GLsizei>(sphereIndices.size()))) {
+        return -1;
+    }
     
-    // Light position
-    glm::vec3 lightPos = glm::vec3(2.0f, 3.0f, 2.0f);
-    
-    // Time tracking for animation
-    float lastFrame = 0.0f;
+    // Physics runs on its own thread at a fixed 60 Hz; each frame draws the
+    // newest snapshot it has published
+    SimulationThread simThread(sim, 1.0f / 60.0f);
+    MemoryMonitor memoryMonitor("sim");
+    if (allocStats) simThread.setMemoryMonitor(&memoryMonitor);
+    if (viewing) {
+        viewer.start();
+    } else {
+        simThread.start();
+    }
+    glm::vec3 sentCameraPos(0.0f), sentCameraFront(0.0f);
+
+    // Trades detail for speed to hold the frame budget, see QualityGovernor.h
+    QualityGovernor governor(frameBudgetMs, 1000.0f / 60.0f);
+    GpuTimer gpuTimer;
+    gpuTimer.init();
 
     // Main loop
     while (!glfwWindowShouldClose(window)) {
-        // Calculate delta time
-        float currentFrame = glfwGetTime();
-        float deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+        double frameStart = glfwGetTime();
 
         // Process input
         float cameraSpeed = 2.5f * 0.016f; // Adjust speed based on delta time
@@ -348,71 +581,86 @@ int main() {
         static bool pKeyPressed = false;
         if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
             if (!pKeyPressed) {
-                isPaused = !isPaused; // Toggle pause state
-                pKeyPressed = true;
-
-                if (isPaused) {
-                    spawnTimer = 0.0f; // Reset spawn timer
+                if (viewing) {
+                    std::cout << "Pause is controlled by the server this viewer is connected to" << std::endl;
+                } else {
+                    simThread.togglePause(); // Toggle pause state
                 }
+                pKeyPressed = true;
             }
         } else {
             pKeyPressed = false;
         }
 
-        // Replay functionality
+        // Replay functionality (a viewer's simulation thread never runs)
+        static bool rKeyPressed = false;
         if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
-            for (auto& droplet : droplets) {
-                droplet.position = glm::vec3(static_cast<float>(rand()) / RAND_MAX * 4.0f - 2.0f, 5.0f, 0.0f); // Reset to random x position
-                droplet.velocity = glm::vec3(0.0f, 0.0f, 0.0f); // Reset velocity
-                droplet.size = 0.25f; // Reset size
-                droplet.hasCollided = false; // Reset collision state
+            if (!viewing) {
+                simThread.requestReset(); // Clear all droplets and particles
+            } else if (!rKeyPressed) {
+                std::cout << "Reset is controlled by the server this viewer is connected to" << std::endl;
             }
-            particles.clear(); // Clear all particles
-            droplets.clear(); // Clear all droplets
-            spawnTimer = 0.0f; // Reset spawn timer
+            rKeyPressed = true;
+        } else {
+            rKeyPressed = false;
         }
 
-        // spawn new droplet every 1 second
-        spawnTimer += deltaTime;
-        if (spawnTimer >= 0.005f) {
-            float randomX = static_cast<float>(rand()) / RAND_MAX * 10.0f - 5.0f; // Range: [-5.0f, 5.0f]
-            float randomZ = static_cast<float>(rand()) / RAND_MAX * 10.0f - 5.0f; // Range: [-5.0f, 5.0f]
-            glm::vec3 spawnPosition = glm::vec3(randomX, 5.0f, randomZ);
-            glm::vec3 spawnVelocity = glm::vec3(0.0f, 0.0f, 0.0f);
-            float spawnSize = 0.3f;
-            droplets.emplace_back(spawnPosition, spawnVelocity, spawnSize);
-            spawnTimer = 0.0f;
+        // Keep the simulated rain around the camera
+        if (followCamera) {
+            simThread.setFocus(glm::vec2(cameraPos.x, cameraPos.z));
         }
 
-        // Update droplet physics
-        if (!isPaused) {
-            for (auto& droplet : droplets) {
-                droplet.update(deltaTime, particles);
+#ifdef SHADER_HOT_RELOAD
+        // Dev builds relink when a shader file changes; a broken edit keeps the old program
+        static long shaderStamp = shaderSourceStamp("vertex_shader.glsl") + shaderSourceStamp("fragment_shader.glsl");
+        long stamp = shaderSourceStamp("vertex_shader.glsl") + shaderSourceStamp("fragment_shader.glsl");
+        if (stamp != shaderStamp) {
+            shaderStamp = stamp;
+            GLuint reloaded = createProgram(shaderSource("vertex_shader.glsl").c_str(),
+                                            shaderSource("fragment_shader.glsl").c_str());
+            if (reloaded) {
+                glDeleteProgram(shaderProgram);
+                shaderProgram = reloaded;
             }
+        }
+#endif
 
-            droplets.erase(std::remove_if(droplets.begin(), droplets.end(),
-            [](const Droplet& droplet) {
-                return droplet.velocity == glm::vec3(0.0f);
-            }),
-            droplets.end());
-
-            // Update particles for droplet
-            for (auto it = particles.begin(); it != particles.end();) {
-                it->position += it->velocity * deltaTime;
-                it->velocity.y -= 9.8f * deltaTime;
-                it->life -= deltaTime; // Decrease lifetime
-            
-                // Remove dead particles
-                if (it->life <= 0.0f) {
-                    it = particles.erase(it);
-                } else {
-                    ++it;
-                }
+        // The server culls to this viewer's camera
+        if (viewing && (cameraPos != sentCameraPos || cameraFront != sentCameraFront)) {
+            viewer.setCamera(cameraPos, cameraFront);
+            sentCameraPos = cameraPos;
+            sentCameraFront = cameraFront;
+        }
+
+        // Pick up the latest simulation state (kept if nothing new was published)
+        if (viewing) {
+            viewer.acquire();
+        } else {
+            simThread.acquire();
+        }
+        const RenderSnapshot& snapshot = viewing ? viewer.snapshot() : simThread.snapshot();
+
+        if (sim.gpuSplashes) {
+            if (snapshot.time < lastSplashTime) {
+                splashes.clear(); // The simulation was reset
             }
+            lastSplashTime = snapshot.time;
+            simThread.takeSplashes(newSplashes);
+            splashes.upload(newSplashes);
+            splashes.retire(snapshot.time);
+        }
+
+        gpuTimer.begin();
+
+        // Rain shadows first, into their own depth map: one draw for every
+        // drop and particle, a point each
+        if (shadowSize > 0) {
+            shadows.render(followCamera ? glm::vec2(cameraPos.x, cameraPos.z) : regionCentre,
+                           snapshot.droplets, snapshot.particles);
         }
 
         // Clear the screen
-        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+        glClearColor(clearColor.x, clearColor.y, clearColor.z, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Use shader program
@@ -434,18 +682,8 @@ int main() {
         glUseProgram(shaderProgram);
         
         //Set uniforms
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos2"), 1, glm::value_ptr(lightPos2));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos"), 1, glm::value_ptr(lightPos));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(cameraPos));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        
-        glm::vec3 waterColor = glm::vec3(0.2f, 0.5f, 0.8f); // More natural blue color for water
-        glUniform3fv(glGetUniformLocation(shaderProgram, "dropletColor"), 1, glm::value_ptr(waterColor));; // Blue color for the droplets
-
-        // Draw the ground
-        glm::vec3 groundColor = glm::vec3(0.7f, 0.65f, 0.5f); // Sandy brown
-        glUniform3fv(glGetUniformLocation(shaderProgram, "groundColor"), 1, glm::value_ptr(groundColor));
+        setSceneUniforms(shaderProgram, view, projection, lightPos);
+        shadows.bind(shaderProgram);
 
         // Make sure depth testing is enabled before drawing the ground
         glEnable(GL_DEPTH_TEST);
@@ -454,6 +692,11 @@ int main() {
         // Draw ground first (it's opaque)
         glBindVertexArray(groundVAO);
         glm::mat4 groundModel = glm::mat4(1.0f);
+        if (followCamera) {
+            // The ground goes on as far as the streaks do
+            groundModel = glm::translate(groundModel, glm::vec3(cameraPos.x, 0.0f, cameraPos.z));
+            groundModel = glm::scale(groundModel, glm::vec3(10.0f, 1.0f, 10.0f));
+        }
         glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(groundModel));
 
         // Make the ground plane completely opaque
@@ -461,36 +704,102 @@ int main() {
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
         glEnable(GL_BLEND);
 
+        // Sky goes after the opaque ground so the depth test skips the pixels
+        // it covers, but before the droplets so they blend over the sky
+        // rather than over the clear colour
+        skybox.update();
+        skybox.draw(view, projection);
+
+        // Distant rain next, behind everything that's simulated; it thins
+        // out with the rest of the rain when the governor lightens it
+        if (followCamera) {
+            streaks.density = governor.settings().spawnScale;
+            streaks.draw(view, projection, cameraPos, snapshot.time);
+        }
+        glUseProgram(shaderProgram);
+
         // Now set up for transparent objects
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         
-        // Render water droplet if it hasn't collided yet
-        for (const auto& droplet : droplets) {
-            if (!droplet.hasCollided) {
-                glBindVertexArray(VAO);
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, droplet.position);
-                
-                // Add slight rotation to make droplets look more dynamic
-                float rotationAngle = glfwGetTime() * 0.5f; // Slow rotation
-                model = glm::rotate(model, rotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-                
-                model = glm::scale(model, glm::vec3(droplet.size));
-                glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-                
-                // Draw droplet with transparency
-                glDrawElements(GL_TRIANGLES, sphereIndices.size(), GL_UNSIGNED_INT, 0);
+        // Past the LOD distance drops and particles get the low-poly mesh
+        float lodDistance = governor.settings().lodDistance;
+        float lodDistance2 = lodDistance * lodDistance;
+
+        // Puddles: pooled drops squashed flat onto the ground, where they
+        // take the rain's shadow like the ground does
+        GLint puddleLocation = glGetUniformLocation(shaderProgram, "puddle");
+        glUniform1i(puddleLocation, 1);
+        glBindVertexArray(lowVAO);
+        for (const auto& puddle : snapshot.puddles) {
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(puddle.x, sim.groundHeight + PUDDLE_LIFT, puddle.z));
+            model = glm::scale(model, glm::vec3(PUDDLE_SPREAD, PUDDLE_FLATTEN, PUDDLE_SPREAD) * puddle.w);
+            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            glDrawElements(GL_TRIANGLES, lowIndices.size(), GL_UNSIGNED_INT, 0);
+        }
+        glUniform1i(puddleLocation, 0);
+
+        // Render water droplets (the snapshot holds falling and sliding ones).
+        // Following the camera, they fade out towards the edge of the region
+        // as the streaks fade in
+        GLint objectAlphaLocation = glGetUniformLocation(shaderProgram, "objectAlpha");
+        for (const auto& droplet : snapshot.droplets) {
+            glm::vec3 offset = glm::vec3(droplet) - cameraPos;
+            if (followCamera) {
+                float horizontal = glm::length(glm::vec2(offset.x, offset.z));
+                float fade = 1.0f - glm::smoothstep(simRadius - streaks.blendWidth, simRadius, horizontal);
+                if (fade <= 0.0f) continue;
+                glUniform1f(objectAlphaLocation, fade);
             }
+            bool low = glm::dot(offset, offset) > lodDistance2;
+            glBindVertexArray(low ? lowVAO : VAO);
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(droplet));
+            
+            // Add slight rotation to make droplets look more dynamic
+            float rotationAngle = glfwGetTime() * 0.5f; // Slow rotation
+            model = glm::rotate(model, rotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
+            
+            model = glm::scale(model, glm::vec3(droplet.w));
+            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            
+            // Draw droplet with transparency
+            glDrawElements(GL_TRIANGLES, low ? lowIndices.size() : sphereIndices.size(), GL_UNSIGNED_INT, 0);
         }
+        glUniform1f(objectAlphaLocation, 1.0f);
 
          // Render droplet particles
-        for (const auto& particle : particles) {
-            glBindVertexArray(VAO); // Use the same VAO as the droplet
+        for (const auto& particle : snapshot.particles) {
+            glm::vec3 offset = glm::vec3(particle) - cameraPos;
+            bool low = glm::dot(offset, offset) > lodDistance2;
+            glBindVertexArray(low ? lowVAO : VAO); // Use the same VAO as the droplet
             glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, particle.position);
-            model = glm::scale(model, glm::vec3(particle.size));
+            model = glm::translate(model, glm::vec3(particle));
+            model = glm::scale(model, glm::vec3(particle.w));
             glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glDrawElements(GL_TRIANGLES, sphereIndices.size(), GL_UNSIGNED_INT, 0);
+            glDrawElements(GL_TRIANGLES, low ? lowIndices.size() : sphereIndices.size(), GL_UNSIGNED_INT, 0);
+        }
+
+        // GPU splashes: one instanced draw, positions worked out in the shader
+        if (sim.gpuSplashes) {
+            glUseProgram(splashes.program());
+            setSceneUniforms(splashes.program(), view, projection, lightPos);
+            shadows.bind(splashes.program());
+            splashes.draw(snapshot.time);
+            glUseProgram(shaderProgram);
+        }
+        gpuTimer.end();
+
+        // Render time is the CPU's or the GPU's, whichever is longer; the
+        // swap is left out since it waits for vsync
+        if (frameBudgetMs > 0.0f) {
+            float cpuMs = static_cast<float>((glfwGetTime() - frameStart) * 1000.0);
+            float renderMs = std::max(cpuMs, gpuTimer.milliseconds());
+            float stepMs = viewing ? 0.0f : simThread.stepMilliseconds(); // The server's steps aren't ours to pace
+            if (governor.update(renderMs, stepMs, static_cast<float>(glfwGetTime()))) {
+                std::cout << governor.describeChange() << std::endl;
+                simThread.setQuality(governor.settings());
+            }
         }
        
         // Swap buffers and poll events
@@ -499,6 +808,16 @@ int main() {
     }
     
     // Clean up
+    simThread.stop();
+    viewer.stop();
+    skybox.destroy();
+    streaks.destroy();
+    shadows.destroy();
+    splashes.destroy();
+    gpuTimer.destroy();
+    glDeleteVertexArrays(1, &lowVAO);
+    glDeleteBuffers(1, &lowVBO);
+    glDeleteBuffers(1, &lowEBO);
     glDeleteVertexArrays(1, &VAO);
     glDeleteVertexArrays(1, &groundVAO);
     glDeleteBuffers(1, &VBO);
@@ -0,0 +1,119 @@
+#include "AllocStats.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+const char* const ALLOC_SUBSYSTEM_NAMES[ALLOC_SUBSYSTEM_COUNT] = {
+    "other", "spawn", "wind", "droplets", "splashes", "particles", "publish", "mesh"
+};
+
+// Plain zero-initialised thread locals: operator new can run before any
+// constructor would have, including while a thread is being set up
+static thread_local AllocCounts threadCounts;
+static thread_local AllocSubsystem currentSubsystem = ALLOC_OTHER;
+
+static std::atomic<size_t> liveBytes(0);
+static std::atomic<size_t> peakBytes(0);
+
+AllocCounts threadAllocCounts() {
+    return threadCounts;
+}
+
+size_t heapLiveBytes() {
+    return liveBytes.load(std::memory_order_relaxed);
+}
+
+size_t heapPeakBytes() {
+    return peakBytes.load(std::memory_order_relaxed);
+}
+
+AllocScope::AllocScope(AllocSubsystem subsystem) : previous(currentSubsystem) {
+    currentSubsystem = subsystem;
+}
+
+AllocScope::~AllocScope() {
+    currentSubsystem = previous;
+}
+
+#ifdef RAIN_ALLOC_STATS
+
+bool allocStatsEnabled() {
+    return true;
+}
+
+// Each block carries its size in front so delete can subtract it; 16 bytes
+// keeps the pointer handed out as aligned as malloc's
+const size_t BLOCK_HEADER = 16;
+
+static void* countedAlloc(size_t size) {
+    void* block = std::malloc(size + BLOCK_HEADER);
+    if (!block) return NULL;
+    *static_cast<size_t*>(block) = size;
+
+    threadCounts.count[currentSubsystem]++;
+    threadCounts.bytes[currentSubsystem] += size;
+    size_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+
+    return static_cast<char*>(block) + BLOCK_HEADER;
+}
+
+static void countedFree(void* pointer) {
+    if (!pointer) return;
+    char* block = static_cast<char*>(pointer) - BLOCK_HEADER;
+    liveBytes.fetch_sub(*reinterpret_cast<size_t*>(block), std::memory_order_relaxed);
+    std::free(block);
+}
+
+// Over-aligned new/delete aren't replaced; the library's versions pair up
+// with each other and aren't used by anything here
+void* operator new(size_t size) {
+    void* pointer = countedAlloc(size);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    countedFree(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    countedFree(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    countedFree(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    countedFree(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    countedFree(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    countedFree(pointer);
+}
+
+#else
+
+bool allocStatsEnabled() {
+    return false;
+}
+
+#endif
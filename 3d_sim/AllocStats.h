@@ -0,0 +1,60 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Opt-in heap allocation counting, built with: make ALLOC_STATS=1
+//
+// That build replaces the global operator new/delete with versions that
+// count every allocation against the current thread and the subsystem named
+// by the innermost ALLOC_SCOPE on it, and keep a process-wide live/peak byte
+// count. In normal builds ALLOC_SCOPE is empty and the counters stay zero.
+enum AllocSubsystem {
+    ALLOC_OTHER,
+    ALLOC_SPAWN,     // New drops
+    ALLOC_WIND,      // Field rebuild and sampling
+    ALLOC_DROPLETS,  // Lifecycle passes and bucket moves
+    ALLOC_SPLASHES,  // Particles thrown up on impact
+    ALLOC_PARTICLES, // Particle update, compaction and GPU hand-off
+    ALLOC_PUBLISH,   // Render snapshots
+    ALLOC_MESH,      // Mesh builders at startup
+    ALLOC_SUBSYSTEM_COUNT
+};
+
+extern const char* const ALLOC_SUBSYSTEM_NAMES[ALLOC_SUBSYSTEM_COUNT];
+
+// Running totals; subtract two of them to get the allocations in between
+struct AllocCounts {
+    uint64_t count[ALLOC_SUBSYSTEM_COUNT];
+    uint64_t bytes[ALLOC_SUBSYSTEM_COUNT];
+};
+
+// Totals for the calling thread since it started
+AllocCounts threadAllocCounts();
+
+// Heap bytes held through operator new across all threads, now and at most
+size_t heapLiveBytes();
+size_t heapPeakBytes();
+
+// True in ALLOC_STATS builds
+bool allocStatsEnabled();
+
+class AllocScope {
+public:
+    explicit AllocScope(AllocSubsystem subsystem);
+    ~AllocScope();
+
+private:
+    AllocSubsystem previous;
+};
+
+#ifdef RAIN_ALLOC_STATS
+#define ALLOC_SCOPE_JOIN(a, b) a##b
+#define ALLOC_SCOPE_NAME(line) ALLOC_SCOPE_JOIN(allocScope, line)
+#define ALLOC_SCOPE(subsystem) AllocScope ALLOC_SCOPE_NAME(__LINE__)(subsystem)
+#else
+#define ALLOC_SCOPE(subsystem)
+#endif
+
+#endif
@@ -0,0 +1,140 @@
+#include "Channel.h"
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <algorithm>
+
+SharedRing* SharedRing::create(size_t capacity) {
+    // Round up to a power of two so wraparound is a mask
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+
+    void* memory = mmap(nullptr, sizeof(SharedRing) + size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANON, -1, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "ERROR::CHANNEL::MMAP_FAILED: " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    SharedRing* ring = new (memory) SharedRing();
+    ring->head.store(0);
+    ring->tail.store(0);
+    ring->capacity = size;
+    return ring;
+}
+
+void SharedRing::destroy(SharedRing* ring) {
+    if (ring) munmap(ring, sizeof(SharedRing) + ring->capacity);
+}
+
+size_t SharedRing::write(const void* source, size_t bytes) {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    uint64_t t = tail.load(std::memory_order_acquire);
+    size_t count = std::min<size_t>(bytes, capacity - (h - t));
+    if (count == 0) return 0;
+
+    size_t offset = h & (capacity - 1);
+    size_t first = std::min<size_t>(count, capacity - offset);
+    std::memcpy(data() + offset, source, first);
+    std::memcpy(data(), static_cast<const unsigned char*>(source) + first, count - first);
+
+    head.store(h + count, std::memory_order_release);
+    return count;
+}
+
+size_t SharedRing::read(void* dest, size_t bytes) {
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    uint64_t h = head.load(std::memory_order_acquire);
+    size_t count = std::min<size_t>(bytes, h - t);
+    if (count == 0) return 0;
+
+    size_t offset = t & (capacity - 1);
+    size_t first = std::min<size_t>(count, capacity - offset);
+    std::memcpy(dest, data() + offset, first);
+    std::memcpy(static_cast<unsigned char*>(dest) + first, data(), count - first);
+
+    tail.store(t + count, std::memory_order_release);
+    return count;
+}
+
+SocketChannel::SocketChannel(int fd) : fd(fd), peerGone(false) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    int noDelay = 1; // Step messages are small; don't let Nagle hold them back
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+}
+
+SocketChannel::~SocketChannel() {
+    close(fd);
+}
+
+size_t SocketChannel::tryWrite(const void* data, size_t bytes) {
+    if (bytes == 0) return 0;
+    ssize_t sent = send(fd, data, bytes, 0);
+    if (sent > 0) return static_cast<size_t>(sent);
+    fail("SEND_FAILED", sent);
+    return 0;
+}
+
+size_t SocketChannel::tryRead(void* data, size_t bytes) {
+    if (bytes == 0) return 0; // recv would return 0, which reads as EOF
+    ssize_t received = recv(fd, data, bytes, 0);
+    if (received > 0) return static_cast<size_t>(received);
+    fail("RECEIVE_FAILED", received);
+    return 0;
+}
+
+// Only a full or empty socket is worth retrying; EOF and real errors close it
+void SocketChannel::fail(const char* what, ssize_t result) {
+    if (peerGone) return;
+    if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+    peerGone = true;
+    if (result == 0) {
+        std::cerr << "ERROR::CHANNEL::PEER_CLOSED" << std::endl;
+    } else {
+        std::cerr << "ERROR::CHANNEL::" << what << ": " << std::strerror(errno) << std::endl;
+    }
+}
+
+bool SocketChannel::createLoopbackPair(int fds[2]) {
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0; // Any free port
+    socklen_t length = sizeof(address);
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0 ||
+        bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listener, 1) < 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) < 0) {
+        std::cerr << "ERROR::CHANNEL::LISTEN_FAILED: " << std::strerror(errno) << std::endl;
+        if (listener >= 0) close(listener);
+        return false;
+    }
+
+    fds[0] = socket(AF_INET, SOCK_STREAM, 0);
+    if (fds[0] < 0 || connect(fds[0], reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "ERROR::CHANNEL::CONNECT_FAILED: " << std::strerror(errno) << std::endl;
+        if (fds[0] >= 0) close(fds[0]);
+        close(listener);
+        return false;
+    }
+
+    fds[1] = accept(listener, nullptr, nullptr);
+    close(listener);
+    if (fds[1] < 0) {
+        std::cerr << "ERROR::CHANNEL::ACCEPT_FAILED: " << std::strerror(errno) << std::endl;
+        close(fds[0]);
+        return false;
+    }
+    return true;
+}
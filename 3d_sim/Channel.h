@@ -0,0 +1,79 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+// Non-blocking, bidirectional byte pipe between two processes. Both calls
+// move as many bytes as they can right now and return the count (0 if the
+// pipe is full/empty), so callers can interleave sends and receives on many
+// channels without deadlocking. A 0 can also mean the other end is gone;
+// closed() tells the two apart, so callers can give up straight away
+// instead of waiting for bytes that will never come.
+class Channel {
+public:
+    virtual ~Channel() {}
+    virtual size_t tryWrite(const void* data, size_t bytes) = 0;
+    virtual size_t tryRead(void* data, size_t bytes) = 0;
+    virtual bool closed() const { return false; }
+};
+
+// Single-producer/single-consumer byte ring in memory shared across fork().
+// head and tail are running byte counts, each on its own cache line.
+struct SharedRing {
+    std::atomic<uint64_t> head;
+    char padHead[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint64_t> tail;
+    char padTail[64 - sizeof(std::atomic<uint64_t>)];
+    uint64_t capacity; // Power of two
+    // capacity bytes of data follow
+
+    // Map a ring with MAP_SHARED so it survives fork(); returns nullptr on failure
+    static SharedRing* create(size_t capacity);
+    static void destroy(SharedRing* ring);
+
+    size_t write(const void* data, size_t bytes);
+    size_t read(void* data, size_t bytes);
+
+private:
+    unsigned char* data() { return reinterpret_cast<unsigned char*>(this + 1); }
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring counters must be lock-free to share across processes");
+
+// Channel over a pair of shared rings (one per direction)
+class ShmChannel : public Channel {
+public:
+    ShmChannel(SharedRing* out, SharedRing* in) : out(out), in(in) {}
+    size_t tryWrite(const void* data, size_t bytes) override { return out->write(data, bytes); }
+    size_t tryRead(void* data, size_t bytes) override { return in->read(data, bytes); }
+
+private:
+    SharedRing* out;
+    SharedRing* in;
+};
+
+// Channel over one end of a connected loopback TCP socket. EOF or any
+// error other than EAGAIN marks it closed. (A shared ring can't tell that
+// its peer died, so ShmChannel is only ever stalled, never closed.)
+class SocketChannel : public Channel {
+public:
+    explicit SocketChannel(int fd);
+    ~SocketChannel() override;
+    size_t tryWrite(const void* data, size_t bytes) override;
+    size_t tryRead(void* data, size_t bytes) override;
+    bool closed() const override { return peerGone; }
+
+    // Make a connected pair of sockets through 127.0.0.1; false on failure
+    static bool createLoopbackPair(int fds[2]);
+
+private:
+    void fail(const char* what, ssize_t result);
+
+    int fd;
+    bool peerGone;
+};
+
+#endif
@@ -0,0 +1,274 @@
+#include "CompactParticles.h"
+#include "Drag.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// Half float conversions. AArch64 (Apple silicon) and x86 with F16C have them
+// in hardware; elsewhere they're done with integer bit tricks that vectorise
+// (round to nearest even, no table lookups).
+#if defined(__aarch64__)
+static inline uint16_t floatToHalf(float value) {
+    __fp16 half = static_cast<__fp16>(value);
+    uint16_t bits;
+    std::memcpy(&bits, &half, sizeof(bits));
+    return bits;
+}
+
+static inline float halfToFloat(uint16_t bits) {
+    __fp16 half;
+    std::memcpy(&half, &bits, sizeof(bits));
+    return static_cast<float>(half);
+}
+#elif defined(__F16C__)
+static inline uint16_t floatToHalf(float value) {
+    return _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+}
+
+static inline float halfToFloat(uint16_t bits) {
+    return _cvtsh_ss(bits);
+}
+#else
+static inline uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline float bitsFloat(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// All cases are computed and selected so the batch loops stay branch-free
+static inline uint16_t floatToHalf(float value) {
+    const uint32_t infinity = 255u << 23;
+    const uint32_t halfMax = (127u + 16u) << 23;
+    const uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    uint32_t bits = floatBits(value);
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    // Too big goes to inf (NaN stays NaN); tiny results are denormal and the
+    // float add does their rounding; otherwise rebias and round to nearest even
+    uint32_t overflow = 0x7c00u | (static_cast<uint32_t>(bits > infinity) << 9);
+    uint32_t denormal = floatBits(bitsFloat(bits) + bitsFloat(denormMagic)) - denormMagic;
+    uint32_t normal = (bits + (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu + ((bits >> 13) & 1u)) >> 13;
+    uint32_t isOverflow = 0u - static_cast<uint32_t>(bits >= halfMax);
+    uint32_t isDenormal = 0u - static_cast<uint32_t>(bits < (113u << 23));
+    uint32_t half = (overflow & isOverflow) | (~isOverflow & ((denormal & isDenormal) | (normal & ~isDenormal)));
+    return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+static inline float halfToFloat(uint16_t half) {
+    const uint32_t shiftedExponent = 0x7c00u << 13;
+    uint32_t bits = (half & 0x7fffu) << 13;
+    uint32_t exponent = bits & shiftedExponent;
+    bits += (127u - 15u) << 23;
+
+    uint32_t special = bits + ((128u - 16u) << 23); // Inf/NaN
+    uint32_t denormal = floatBits(bitsFloat(bits + (1u << 23)) - bitsFloat(113u << 23));
+    uint32_t isSpecial = 0u - static_cast<uint32_t>(exponent == shiftedExponent);
+    uint32_t isDenormal = 0u - static_cast<uint32_t>(exponent == 0);
+    bits = (special & isSpecial) | (denormal & isDenormal) | (bits & ~(isSpecial | isDenormal));
+    return bitsFloat(bits | (static_cast<uint32_t>(half & 0x8000u) << 16));
+}
+#endif
+
+static inline uint8_t quantizeCode(float value, float low, float high) {
+    float t = (value - low) / (high - low) * 15.0f + 0.5f;
+    return static_cast<uint8_t>(std::min(std::max(t, 0.0f), 15.0f));
+}
+
+// Round to the nearest unit. std::floor is a library call on baseline x86-64,
+// so truncate and correct for negatives instead. Clamped first so a particle
+// that blew up (huge or NaN) lands far outside the tiles rather than being an
+// out-of-range conversion
+static inline int32_t quantizeUnits(float metres) {
+    float units = metres * COMPACT_UNITS_PER_METRE + 0.5f;
+    units = std::min(std::max(-2147483648.0f, units), 2147483520.0f);
+    int32_t q = static_cast<int32_t>(units);
+    return q - (units < static_cast<float>(q));
+}
+
+// Position relative to the origin in 1/4096 m units; the top bits are the
+// tile, the low 16 the offset. False if it falls outside the tile range
+// (the outputs are written either way, which keeps callers branch-free).
+static inline bool packPosition(float x, float y, float z,
+                                uint16_t& offsetX, uint16_t& offsetY, uint16_t& offsetZ, uint16_t& tile) {
+    int32_t qx = quantizeUnits(x), qy = quantizeUnits(y), qz = quantizeUnits(z);
+    uint32_t tx = static_cast<uint32_t>((qx >> 16) + 32);
+    uint32_t ty = static_cast<uint32_t>((qy >> 16) + 8);
+    uint32_t tz = static_cast<uint32_t>((qz >> 16) + 32);
+
+    offsetX = static_cast<uint16_t>(qx & 0xffff);
+    offsetY = static_cast<uint16_t>(qy & 0xffff);
+    offsetZ = static_cast<uint16_t>(qz & 0xffff);
+    tile = static_cast<uint16_t>(((tx & 63) << 10) | ((ty & 15) << 6) | (tz & 63));
+    return (tx | tz) < 64 && ty < 16;
+}
+
+static inline void unpackPosition(const CompactParticle& p, float& x, float& y, float& z) {
+    const float metresPerUnit = 1.0f / COMPACT_UNITS_PER_METRE;
+    int32_t tx = (p.tile >> 10) - 32, ty = ((p.tile >> 6) & 15) - 8, tz = (p.tile & 63) - 32;
+    x = static_cast<float>(tx * 65536 + p.offset[0]) * metresPerUnit;
+    y = static_cast<float>(ty * 65536 + p.offset[1]) * metresPerUnit;
+    z = static_cast<float>(tz * 65536 + p.offset[2]) * metresPerUnit;
+}
+
+CompactParticles::CompactParticles(glm::vec3 origin) : origin(origin) {
+    for (int code = 0; code < 16; code++) {
+        sizeByCode[code] = COMPACT_MIN_SIZE + (COMPACT_MAX_SIZE - COMPACT_MIN_SIZE) * code / 15.0f;
+        dragByCode[code] = dragCoefficient(sizeByCode[code]);
+    }
+}
+
+void CompactParticles::add(const Particle& particle) {
+    CompactParticle p;
+    glm::vec3 local = particle.position - origin;
+    if (!packPosition(local.x, local.y, local.z, p.offset[0], p.offset[1], p.offset[2], p.tile) ||
+        particle.life <= 0.0f) {
+        return;
+    }
+
+    p.velocity[0] = floatToHalf(particle.velocity.x);
+    p.velocity[1] = floatToHalf(particle.velocity.y);
+    p.velocity[2] = floatToHalf(particle.velocity.z);
+    float fraction = std::min(particle.life / particle.maxLife, 1.0f);
+    p.life = static_cast<uint8_t>(std::max(fraction * 255.0f + 0.5f, 1.0f));
+    p.codes = static_cast<uint8_t>((quantizeCode(particle.size, COMPACT_MIN_SIZE, COMPACT_MAX_SIZE) << 4) |
+                                   quantizeCode(particle.maxLife, COMPACT_MIN_LIFE, COMPACT_MAX_LIFE));
+    items.push_back(p);
+}
+
+void CompactParticles::rebase(glm::vec2 centre) {
+    int shiftX = static_cast<int>(std::floor((centre.x - origin.x) / COMPACT_TILE_SIZE + 0.5f));
+    int shiftZ = static_cast<int>(std::floor((centre.y - origin.z) / COMPACT_TILE_SIZE + 0.5f));
+    if (std::abs(shiftX) < COMPACT_REBASE_TILES && std::abs(shiftZ) < COMPACT_REBASE_TILES) return;
+
+    origin.x += shiftX * COMPACT_TILE_SIZE;
+    origin.z += shiftZ * COMPACT_TILE_SIZE;
+    size_t out = 0;
+    for (size_t i = 0; i < items.size(); i++) {
+        CompactParticle p = items[i];
+        int tx = (p.tile >> 10) - shiftX, tz = (p.tile & 63) - shiftZ;
+        if (tx < 0 || tx >= 64 || tz < 0 || tz >= 64) continue;
+        p.tile = static_cast<uint16_t>((tx << 10) | (p.tile & (15 << 6)) | tz);
+        items[out++] = p;
+    }
+    items.resize(out);
+}
+
+template <typename Integrator>
+void CompactParticles::update(float deltaTime, const WindField& wind, unsigned step) {
+    const size_t B = WindField::BATCH;
+    float px[B], py[B], pz[B];
+    float vx[B], vy[B], vz[B];
+    float wx[B], wy[B], wz[B];
+
+    const float LIFE_PER_CODE = (COMPACT_MAX_LIFE - COMPACT_MIN_LIFE) / 15.0f;
+    const float lifeUnits = 255.0f * deltaTime;
+
+    size_t count = items.size();
+    size_t out = 0;
+    for (size_t start = 0; start < count; start += B) {
+        size_t n = std::min(count - start, B);
+        const CompactParticle* in = &items[start];
+
+        // Unpack to world-space SoA
+        for (size_t i = 0; i < n; i++) {
+            unpackPosition(in[i], px[i], py[i], pz[i]);
+            px[i] += origin.x;
+            py[i] += origin.y;
+            pz[i] += origin.z;
+            vx[i] = halfToFloat(in[i].velocity[0]);
+            vy[i] = halfToFloat(in[i].velocity[1]);
+            vz[i] = halfToFloat(in[i].velocity[2]);
+        }
+
+        wind.sampleBatch(px, py, pz, wx, wy, wz, n);
+
+        for (size_t i = 0; i < n; i++) {
+            glm::vec3 position(px[i], py[i], pz[i]);
+            glm::vec3 velocity(vx[i], vy[i], vz[i]);
+            Integrator::step(position, velocity,
+                             AirForces(glm::vec3(wx[i], wy[i], wz[i]), dragByCode[in[i].codes >> 4]), deltaTime);
+            px[i] = position.x - origin.x;
+            py[i] = position.y - origin.y;
+            pz[i] = position.z - origin.z;
+            vx[i] = velocity.x;
+            vy[i] = velocity.y;
+            vz[i] = velocity.z;
+        }
+
+        // Age and quantize into SoA staging arrays; with no branches or
+        // struct stores this loop vectorises like the unpack one
+        uint16_t ox[B], oy[B], oz[B], tile[B], hx[B], hy[B], hz[B];
+        uint8_t life[B];
+        bool keep[B];
+        for (size_t i = 0; i < n; i++) {
+            // 8-bit life loses a fractional number of units per step; a dither
+            // that walks through [0, 1) across particles and steps rounds it
+            // up or down so lifetimes come out right on average
+            float maxLife = COMPACT_MIN_LIFE + LIFE_PER_CODE * (in[i].codes & 15);
+            uint32_t ramp = (static_cast<uint32_t>(start + i) * 37u + step * 101u) & 255u;
+            float dither = static_cast<float>(ramp) * (1.0f / 256.0f);
+            int remaining = in[i].life - static_cast<int>(lifeUnits / maxLife + dither);
+
+            bool inRange = packPosition(px[i], py[i], pz[i], ox[i], oy[i], oz[i], tile[i]);
+            keep[i] = inRange & (remaining > 0);
+            life[i] = static_cast<uint8_t>(remaining);
+            hx[i] = floatToHalf(vx[i]);
+            hy[i] = floatToHalf(vy[i]);
+            hz[i] = floatToHalf(vz[i]);
+        }
+
+        // Assemble each survivor in two 64-bit words and write it over the
+        // front of the array (out never passes start + i, so nothing unread
+        // is overwritten)
+        for (size_t i = 0; i < n; i++) {
+            uint64_t words[2];
+            words[0] = ox[i] | (static_cast<uint64_t>(oy[i]) << 16) |
+                       (static_cast<uint64_t>(oz[i]) << 32) | (static_cast<uint64_t>(tile[i]) << 48);
+            words[1] = hx[i] | (static_cast<uint64_t>(hy[i]) << 16) | (static_cast<uint64_t>(hz[i]) << 32) |
+                       (static_cast<uint64_t>(life[i]) << 48) | (static_cast<uint64_t>(in[i].codes) << 56);
+            std::memcpy(&items[out], words, sizeof(words));
+            out += keep[i];
+        }
+    }
+    items.resize(out);
+}
+
+template void CompactParticles::update<ExplicitEuler>(float, const WindField&, unsigned);
+template void CompactParticles::update<SemiImplicitEuler>(float, const WindField&, unsigned);
+template void CompactParticles::update<VelocityVerlet>(float, const WindField&, unsigned);
+
+void CompactParticles::appendRenderData(std::vector<glm::vec4>& out) const {
+    out.reserve(out.size() + items.size());
+    for (const CompactParticle& p : items) {
+        float x, y, z;
+        unpackPosition(p, x, y, z);
+        out.push_back(glm::vec4(origin.x + x, origin.y + y, origin.z + z, sizeByCode[p.codes >> 4]));
+    }
+}
+
+glm::vec3 CompactParticles::position(size_t i) const {
+    float x, y, z;
+    unpackPosition(items[i], x, y, z);
+    return origin + glm::vec3(x, y, z);
+}
+
+glm::vec3 CompactParticles::velocity(size_t i) const {
+    const CompactParticle& p = items[i];
+    return glm::vec3(halfToFloat(p.velocity[0]), halfToFloat(p.velocity[1]), halfToFloat(p.velocity[2]));
+}
+
+float CompactParticles::particleSize(size_t i) const {
+    return sizeByCode[items[i].codes >> 4];
+}
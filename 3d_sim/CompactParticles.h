@@ -0,0 +1,82 @@
+#ifndef COMPACT_PARTICLES_H
+#define COMPACT_PARTICLES_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "Particle.h"
+#include "WindField.h"
+#include "Integrators.h"
+
+// 16-byte splash particle for scenes with tens of millions of them
+// (a full Particle is 52 bytes).
+//
+//  - position: 16-bit offsets inside a 16 m tile (0.24 mm steps) plus the
+//    tile's coordinates packed into 16 bits (x/z 6 bits, y 4 bits)
+//  - velocity: three half floats
+//  - life: remaining fraction of the lifetime in 8 bits
+//  - size and lifetime: 4-bit codes spanning the ranges splashes spawn with
+//
+// Alpha isn't stored (it's 0.9 * life), and wind is sampled on the fly
+// during the update instead of being kept per particle.
+struct CompactParticle {
+    uint16_t offset[3];
+    uint16_t tile;
+    uint16_t velocity[3];
+    uint8_t life;
+    uint8_t codes; // Size code in the high nibble, lifetime code in the low one
+};
+
+static_assert(sizeof(CompactParticle) == 16, "CompactParticle should stay 16 bytes");
+
+// Tile geometry; positions are relative to the store's origin
+const float COMPACT_TILE_SIZE = 16.0f;
+const float COMPACT_UNITS_PER_METRE = 65536.0f / COMPACT_TILE_SIZE;
+
+// Tiles the origin has to be off centre before rebase() moves it
+const int COMPACT_REBASE_TILES = 8;
+
+// Ranges covered by the size/lifetime codes (see createSplashEffect)
+const float COMPACT_MIN_SIZE = 0.015f, COMPACT_MAX_SIZE = 0.06f;
+const float COMPACT_MIN_LIFE = 0.4f, COMPACT_MAX_LIFE = 2.0f;
+
+class CompactParticles {
+public:
+    explicit CompactParticles(glm::vec3 origin);
+
+    // Quantize a particle into the store (dropped if outside the tile range)
+    void add(const Particle& particle);
+    void clear() { items.clear(); }
+
+    // Keep the tile range (about +-512 m around the origin) over a moving
+    // region: once (x, z) is COMPACT_REBASE_TILES tiles from the origin, the
+    // origin moves there in whole tiles. Only the tile coordinates change, so
+    // positions stay exact; particles left outside the range are dropped
+    void rebase(glm::vec2 centre);
+    size_t size() const { return items.size(); }
+    size_t capacity() const { return items.capacity(); }
+
+    // Unpack, sample wind, integrate, age and repack one batch at a time;
+    // dead particles are squeezed out in the same pass.
+    // Instantiated in CompactParticles.cpp for each policy in Integrators.h
+    template <typename Integrator = DefaultIntegrator>
+    void update(float deltaTime, const WindField& wind, unsigned step);
+
+    // xyz + size per particle, as the renderer wants them
+    void appendRenderData(std::vector<glm::vec4>& out) const;
+
+    // On-demand attributes for one particle
+    glm::vec3 position(size_t i) const;
+    glm::vec3 velocity(size_t i) const;
+    float particleSize(size_t i) const;
+    float alpha(size_t i) const { return items[i].life * (0.9f / 255.0f); }
+
+private:
+    glm::vec3 origin;
+    std::vector<CompactParticle> items;
+
+    float sizeByCode[16];
+    float dragByCode[16];
+};
+
+#endif
@@ -0,0 +1,455 @@
+#include "DomainDecomposition.h"
+#include "Channel.h"
+#include "Simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// A droplet or particle handed to the tile it moved into
+struct MigrantRecord {
+    uint32_t kind; // 0 = droplet, 1 = particle
+    float position[3];
+    float velocity[3];
+    float wind[3];
+    float size;
+    float life;         // Particles only
+    float maxLife;      // Particles only
+    float deformFactor; // Droplets only
+};
+
+// Sent to each neighbour every step, followed by count MigrantRecords
+struct MigrantHeader {
+    uint32_t step;
+    uint32_t count;
+};
+
+// Sent to the coordinator every step
+struct TileStats {
+    uint32_t tile;
+    uint32_t step;
+    uint32_t droplets;
+    uint32_t particles;
+    uint32_t sent;
+    uint32_t received;
+    float stepMs;
+    float exchangeMs;
+};
+
+// Give up if a peer makes no progress for this long (it probably died)
+const double STALL_TIMEOUT_SECONDS = 10.0;
+
+struct Neighbour {
+    int tile;
+    Channel* channel;
+};
+
+// Where each tile sits and which tile owns a point
+struct TileGrid {
+    int tilesX, tilesZ;
+    float tileSize;
+    float originX, originZ;
+
+    explicit TileGrid(const DomainConfig& config)
+        : tilesX(config.tilesX), tilesZ(config.tilesZ), tileSize(config.tileSize),
+          originX(-0.5f * config.tilesX * config.tileSize),
+          originZ(-0.5f * config.tilesZ * config.tileSize) {}
+
+    int count() const { return tilesX * tilesZ; }
+
+    // Anything that leaves the world stays with the edge tile
+    int owner(const glm::vec3& p) const {
+        int ix = static_cast<int>(std::floor((p.x - originX) / tileSize));
+        int iz = static_cast<int>(std::floor((p.z - originZ) / tileSize));
+        ix = std::min(std::max(ix, 0), tilesX - 1);
+        iz = std::min(std::max(iz, 0), tilesZ - 1);
+        return ix + iz * tilesX;
+    }
+
+    glm::vec2 tileMin(int tile) const {
+        return glm::vec2(originX + (tile % tilesX) * tileSize, originZ + (tile / tilesX) * tileSize);
+    }
+};
+
+// Write all bytes, spinning while the channel is full; false at once if it closes
+static bool writeAll(Channel* channel, const void* data, size_t bytes) {
+    const unsigned char* bytesLeft = static_cast<const unsigned char*>(data);
+    auto lastProgress = std::chrono::steady_clock::now();
+    while (bytes > 0) {
+        size_t written = channel->tryWrite(bytesLeft, bytes);
+        if (written > 0) {
+            bytesLeft += written;
+            bytes -= written;
+            lastProgress = std::chrono::steady_clock::now();
+        } else {
+            if (channel->closed()) return false;
+            if (std::chrono::duration<double>(std::chrono::steady_clock::now() - lastProgress).count() > STALL_TIMEOUT_SECONDS)
+                return false;
+            sched_yield();
+        }
+    }
+    return true;
+}
+
+// Read exactly bytes, spinning while the channel is empty; false at once if it closes
+static bool readAll(Channel* channel, void* data, size_t bytes) {
+    unsigned char* bytesLeft = static_cast<unsigned char*>(data);
+    auto lastProgress = std::chrono::steady_clock::now();
+    while (bytes > 0) {
+        size_t received = channel->tryRead(bytesLeft, bytes);
+        if (received > 0) {
+            bytesLeft += received;
+            bytes -= received;
+            lastProgress = std::chrono::steady_clock::now();
+        } else {
+            if (channel->closed()) return false;
+            if (std::chrono::duration<double>(std::chrono::steady_clock::now() - lastProgress).count() > STALL_TIMEOUT_SECONDS)
+                return false;
+            sched_yield();
+        }
+    }
+    return true;
+}
+
+// Send this step's outgoing migrants to every neighbour and receive theirs.
+// Sends and receives are interleaved on all channels so two tiles with full
+// rings towards each other keep draining instead of deadlocking.
+static bool exchangeMigrants(const std::vector<Neighbour>& neighbours, uint32_t step,
+                             const std::vector<std::vector<MigrantRecord>>& outgoing,
+                             std::vector<MigrantRecord>& incoming) {
+    size_t n = neighbours.size();
+    std::vector<std::vector<unsigned char>> sendBuffers(n);
+    std::vector<size_t> sendOffsets(n, 0);
+    std::vector<MigrantHeader> headers(n);
+    std::vector<size_t> headerBytes(n, 0);
+    std::vector<std::vector<MigrantRecord>> received(n);
+    std::vector<size_t> receivedBytes(n, 0);
+
+    for (size_t i = 0; i < n; i++) {
+        MigrantHeader header = { step, static_cast<uint32_t>(outgoing[i].size()) };
+        size_t recordBytes = outgoing[i].size() * sizeof(MigrantRecord);
+        sendBuffers[i].resize(sizeof(header) + recordBytes);
+        std::memcpy(sendBuffers[i].data(), &header, sizeof(header));
+        if (recordBytes > 0)
+            std::memcpy(sendBuffers[i].data() + sizeof(header), outgoing[i].data(), recordBytes);
+    }
+
+    auto lastProgress = std::chrono::steady_clock::now();
+    for (;;) {
+        bool done = true, progress = false;
+        for (size_t i = 0; i < n; i++) {
+            Channel* channel = neighbours[i].channel;
+
+            if (sendOffsets[i] < sendBuffers[i].size()) {
+                size_t written = channel->tryWrite(sendBuffers[i].data() + sendOffsets[i],
+                                                   sendBuffers[i].size() - sendOffsets[i]);
+                sendOffsets[i] += written;
+                progress |= written > 0;
+                done &= sendOffsets[i] == sendBuffers[i].size();
+            }
+
+            // Header first, then exactly count records, so we never read into the next step
+            if (headerBytes[i] < sizeof(MigrantHeader)) {
+                size_t got = channel->tryRead(reinterpret_cast<unsigned char*>(&headers[i]) + headerBytes[i],
+                                              sizeof(MigrantHeader) - headerBytes[i]);
+                headerBytes[i] += got;
+                progress |= got > 0;
+                if (headerBytes[i] == sizeof(MigrantHeader)) {
+                    if (headers[i].step != step) {
+                        std::cerr << "ERROR::DOMAIN::STEP_MISMATCH: expected " << step
+                                  << " got " << headers[i].step << std::endl;
+                        return false;
+                    }
+                    received[i].resize(headers[i].count);
+                }
+            }
+            if (headerBytes[i] == sizeof(MigrantHeader)) {
+                size_t total = received[i].size() * sizeof(MigrantRecord);
+                if (receivedBytes[i] < total) {
+                    size_t got = channel->tryRead(reinterpret_cast<unsigned char*>(received[i].data()) + receivedBytes[i],
+                                                  total - receivedBytes[i]);
+                    receivedBytes[i] += got;
+                    progress |= got > 0;
+                }
+                done &= receivedBytes[i] == total;
+            } else {
+                done = false;
+            }
+
+            // A neighbour that died will never finish the exchange
+            if (channel->closed()) {
+                std::cerr << "ERROR::DOMAIN::NEIGHBOUR_CLOSED: tile " << neighbours[i].tile << " at step " << step << std::endl;
+                return false;
+            }
+        }
+
+        if (done) break;
+        if (progress) {
+            lastProgress = std::chrono::steady_clock::now();
+        } else {
+            if (std::chrono::duration<double>(std::chrono::steady_clock::now() - lastProgress).count() > STALL_TIMEOUT_SECONDS) {
+                std::cerr << "ERROR::DOMAIN::EXCHANGE_STALLED at step " << step << std::endl;
+                return false;
+            }
+            sched_yield();
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        incoming.insert(incoming.end(), received[i].begin(), received[i].end());
+    }
+    return true;
+}
+
+static int runWorker(const DomainConfig& config, int tile, const std::vector<Neighbour>& neighbours, Channel* coordinator) {
+    TileGrid grid(config);
+    glm::vec2 tileMin = grid.tileMin(tile);
+    Simulation sim(tileMin, tileMin + glm::vec2(config.tileSize));
+    sim.spawnInterval = 1.0f / (config.rainRate * config.tileSize * config.tileSize);
+    sim.random.seed(1234u + tile);
+
+    // Which neighbour slot each adjacent tile maps to
+    std::vector<int> slotOf(grid.count(), -1);
+    for (size_t i = 0; i < neighbours.size(); i++) {
+        slotOf[neighbours[i].tile] = static_cast<int>(i);
+    }
+
+    std::vector<std::vector<MigrantRecord>> outgoing(neighbours.size());
+    std::vector<MigrantRecord> incoming;
+
+    for (int step = 0; step < config.steps; step++) {
+        auto start = std::chrono::steady_clock::now();
+        sim.step(config.timestep);
+
+        // Pull out everything that is now over a neighbour's tile
+        for (auto& list : outgoing) list.clear();
+        uint32_t sent = 0;
+
+        sim.droplets.erase(std::remove_if(sim.droplets.begin(), sim.droplets.end(),
+        [&](const Droplet& droplet) {
+            int owner = grid.owner(droplet.position);
+            if (owner == tile || slotOf[owner] < 0) return false;
+            MigrantRecord record = {};
+            record.kind = 0;
+            std::memcpy(record.position, &droplet.position.x, sizeof(record.position));
+            std::memcpy(record.velocity, &droplet.velocity.x, sizeof(record.velocity));
+            std::memcpy(record.wind, &droplet.wind.x, sizeof(record.wind));
+            record.size = droplet.size;
+            record.deformFactor = droplet.deformFactor;
+            outgoing[slotOf[owner]].push_back(record);
+            sent++;
+            return true;
+        }),
+        sim.droplets.end());
+
+        sim.particles.erase(std::remove_if(sim.particles.begin(), sim.particles.end(),
+        [&](const Particle& particle) {
+            int owner = grid.owner(particle.position);
+            if (owner == tile || slotOf[owner] < 0) return false;
+            MigrantRecord record = {};
+            record.kind = 1;
+            std::memcpy(record.position, &particle.position.x, sizeof(record.position));
+            std::memcpy(record.velocity, &particle.velocity.x, sizeof(record.velocity));
+            std::memcpy(record.wind, &particle.wind.x, sizeof(record.wind));
+            record.size = particle.size;
+            record.life = particle.life;
+            record.maxLife = particle.maxLife;
+            outgoing[slotOf[owner]].push_back(record);
+            sent++;
+            return true;
+        }),
+        sim.particles.end());
+
+        auto exchangeStart = std::chrono::steady_clock::now();
+        incoming.clear();
+        if (!exchangeMigrants(neighbours, step, outgoing, incoming)) return 1;
+
+        for (const MigrantRecord& record : incoming) {
+            glm::vec3 position(record.position[0], record.position[1], record.position[2]);
+            glm::vec3 velocity(record.velocity[0], record.velocity[1], record.velocity[2]);
+            glm::vec3 wind(record.wind[0], record.wind[1], record.wind[2]);
+            if (record.kind == 0) {
+                sim.droplets.emplace_back(position, velocity, record.size);
+                sim.droplets.back().deformFactor = record.deformFactor;
+                sim.droplets.back().wind = wind;
+            } else {
+                sim.particles.emplace_back(position, velocity, record.size, record.maxLife);
+                sim.particles.back().life = record.life;
+                sim.particles.back().wind = wind;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        TileStats stats;
+        stats.tile = tile;
+        stats.step = step;
+        stats.droplets = static_cast<uint32_t>(sim.droplets.size());
+        stats.particles = static_cast<uint32_t>(sim.particles.size());
+        stats.sent = sent;
+        stats.received = static_cast<uint32_t>(incoming.size());
+        stats.stepMs = std::chrono::duration<float, std::milli>(end - start).count();
+        stats.exchangeMs = std::chrono::duration<float, std::milli>(end - exchangeStart).count();
+        if (!writeAll(coordinator, &stats, sizeof(stats))) {
+            std::cerr << "ERROR::DOMAIN::COORDINATOR_STALLED" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int runDomainDecomposition(const DomainConfig& config) {
+    TileGrid grid(config);
+    int tiles = grid.count();
+    if (tiles < 1 || config.tileSize <= 0.0f || config.rainRate <= 0.0f) {
+        std::cerr << "ERROR::DOMAIN::BAD_CONFIG" << std::endl;
+        return 1;
+    }
+
+    // A dead peer should show up as a failed write, not kill us
+    signal(SIGPIPE, SIG_IGN);
+
+    // Every channel is created up front so fork() hands each worker its ends.
+    // neighbours[t] is tile t's list; coordinatorEnds[t]/workerEnds[t] link t to us.
+    std::vector<std::vector<Neighbour>> neighbours(tiles);
+    std::vector<Channel*> coordinatorEnds(tiles), workerEnds(tiles);
+    std::vector<SharedRing*> rings;
+    std::vector<Channel*> allChannels;
+
+    auto makeLink = [&](Channel*& a, Channel*& b) -> bool {
+        if (config.useSockets) {
+            int fds[2];
+            if (!SocketChannel::createLoopbackPair(fds)) return false;
+            a = new SocketChannel(fds[0]);
+            b = new SocketChannel(fds[1]);
+        } else {
+            SharedRing* forward = SharedRing::create(config.ringBytes);
+            SharedRing* backward = SharedRing::create(config.ringBytes);
+            if (!forward || !backward) return false;
+            rings.push_back(forward);
+            rings.push_back(backward);
+            a = new ShmChannel(forward, backward);
+            b = new ShmChannel(backward, forward);
+        }
+        allChannels.push_back(a);
+        allChannels.push_back(b);
+        return true;
+    };
+
+    bool ok = true;
+    for (int t = 0; t < tiles && ok; t++) {
+        int tx = t % grid.tilesX, tz = t / grid.tilesX;
+        // Link to the 8 surrounding tiles, each pair once
+        for (int dz = -1; dz <= 1 && ok; dz++) {
+            for (int dx = -1; dx <= 1 && ok; dx++) {
+                int nx = tx + dx, nz = tz + dz;
+                if (nx < 0 || nz < 0 || nx >= grid.tilesX || nz >= grid.tilesZ) continue;
+                int other = nx + nz * grid.tilesX;
+                if (other <= t) continue;
+                Channel *a = nullptr, *b = nullptr;
+                ok = makeLink(a, b);
+                if (ok) {
+                    neighbours[t].push_back(Neighbour{ other, a });
+                    neighbours[other].push_back(Neighbour{ t, b });
+                }
+            }
+        }
+        if (ok) ok = makeLink(coordinatorEnds[t], workerEnds[t]);
+    }
+    if (!ok) {
+        std::cerr << "ERROR::DOMAIN::CHANNEL_SETUP_FAILED" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Domain: " << grid.tilesX << "x" << grid.tilesZ << " tiles of "
+              << config.tileSize << " m, " << config.steps << " steps, "
+              << (config.useSockets ? "loopback sockets" : "shared memory") << std::endl;
+
+    std::vector<pid_t> workers;
+    for (int t = 0; t < tiles; t++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "ERROR::DOMAIN::FORK_FAILED" << std::endl;
+            for (pid_t worker : workers) kill(worker, SIGTERM);
+            return 1;
+        }
+        if (pid == 0) {
+            // Close every socket that isn't ours so peers see EOF if we die
+            for (Channel* channel : allChannels) {
+                bool mine = channel == workerEnds[t];
+                for (const Neighbour& neighbour : neighbours[t]) mine |= channel == neighbour.channel;
+                if (!mine) delete channel;
+            }
+            std::cout.flush();
+            _exit(runWorker(config, t, neighbours[t], workerEnds[t]));
+        }
+        workers.push_back(pid);
+    }
+
+    // Likewise drop our copies of every end but our own, or a dead worker's
+    // sockets would stay open here and its peers would never see EOF
+    for (Channel*& channel : allChannels) {
+        if (std::find(coordinatorEnds.begin(), coordinatorEnds.end(), channel) != coordinatorEnds.end()) continue;
+        delete channel;
+        channel = nullptr;
+    }
+
+    // Coordinator: gather one TileStats per tile per step and report totals
+    auto start = std::chrono::steady_clock::now();
+    uint64_t totalMigrants = 0;
+    int exitCode = 0;
+    for (int step = 0; step < config.steps && exitCode == 0; step++) {
+        uint64_t droplets = 0, particles = 0, migrants = 0;
+        float slowestStep = 0.0f, slowestExchange = 0.0f, totalStep = 0.0f;
+        for (int t = 0; t < tiles; t++) {
+            TileStats stats;
+            if (!readAll(coordinatorEnds[t], &stats, sizeof(stats))) {
+                std::cerr << "ERROR::DOMAIN::" << (coordinatorEnds[t]->closed() ? "WORKER_CLOSED" : "WORKER_STALLED")
+                          << ": tile " << t << std::endl;
+                exitCode = 1;
+                break;
+            }
+            droplets += stats.droplets;
+            particles += stats.particles;
+            migrants += stats.sent;
+            slowestStep = std::max(slowestStep, stats.stepMs);
+            slowestExchange = std::max(slowestExchange, stats.exchangeMs);
+            totalStep += stats.stepMs;
+        }
+        totalMigrants += migrants;
+
+        if (exitCode == 0 && ((step + 1) % config.reportInterval == 0 || step + 1 == config.steps)) {
+            std::cout << "step " << step + 1
+                      << "  droplets " << droplets
+                      << "  particles " << particles
+                      << "  migrants " << migrants
+                      << "  step ms avg " << totalStep / tiles
+                      << " max " << slowestStep
+                      << "  exchange ms max " << slowestExchange << std::endl;
+        }
+    }
+    if (exitCode != 0) {
+        for (pid_t worker : workers) kill(worker, SIGTERM);
+    }
+
+    for (pid_t worker : workers) {
+        int status = 0;
+        waitpid(worker, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) exitCode = 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Done in " << seconds << " s (" << config.steps / seconds << " steps/s), "
+              << totalMigrants << " migrants exchanged" << std::endl;
+
+    for (Channel* channel : allChannels) delete channel;
+    for (SharedRing* ring : rings) SharedRing::destroy(ring);
+    return exitCode;
+}
@@ -0,0 +1,30 @@
+#ifndef DOMAIN_DECOMPOSITION_H
+#define DOMAIN_DECOMPOSITION_H
+
+#include <cstddef>
+
+// Headless mode that tiles a large ground area across worker processes on
+// this host. Each worker owns one tile and runs a Simulation over it; drops
+// and splash particles that cross into a neighbouring tile are handed over
+// every step through shared-memory rings (or loopback sockets), and a
+// coordinator process gathers per-tile stats.
+struct DomainConfig {
+    int tilesX, tilesZ;
+    float tileSize;       // Metres per tile side
+    int steps;
+    float timestep;       // Fixed seconds per step
+    float rainRate;       // Drops per square metre per second
+    bool useSockets;      // Loopback TCP instead of shared memory
+    int reportInterval;   // Steps between coordinator reports
+    size_t ringBytes;     // Capacity of each shared ring
+
+    DomainConfig()
+        : tilesX(2), tilesZ(2), tileSize(250.0f), steps(600), timestep(1.0f / 60.0f),
+          rainRate(0.02f), useSockets(false), reportInterval(60), ringBytes(1 << 20) {}
+};
+
+// Fork one worker per tile and coordinate them until all steps are done.
+// Returns the process exit code (non-zero if setup or any worker failed).
+int runDomainDecomposition(const DomainConfig& config);
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef DRAG_H
+#define DRAG_H
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <algorithm>
+
+// Size-dependent air drag for water drops.
+//
+// Terminal velocity follows Best (1950), Vt = 9.43 * (1 - exp(-(D / 1.77)^1.147))
+// with D in mm, which tracks the Gunn-Kinzer measurements from drizzle up to
+// large flattened drops. Drag is modelled as quadratic in the air-relative
+// velocity, a = -g |v| v / Vt^2, so each size falls at its measured speed.
+//
+// Both Vt and the drag coefficient g / Vt^2 are tabulated over diameter at
+// compile time, so the per-particle cost is one table lerp and a sqrt.
+
+// Real drop diameter (mm) per unit of simulation size: spawned rain drops
+// (size 0.3) are 2 mm, splash particles (0.02 - 0.06) are 0.13 - 0.4 mm
+const float DIAMETER_PER_SIZE = 20.0f / 3.0f;
+
+const int DRAG_TABLE_SIZE = 256;
+const float DRAG_TABLE_MAX_DIAMETER = 8.0f; // mm, larger drops break up
+const float DRAG_TABLE_MIN_DIAMETER = 0.05f; // mm, keeps Vt away from zero
+
+// constexpr stand-ins for exp/log/pow, only used to build the tables
+constexpr double constExp(double x) {
+    // exp(x) = exp(x / 2^16)^(2^16), with a short Taylor series for the small part
+    double small = x / 65536.0;
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 8; n++) {
+        term *= small / n;
+        sum += term;
+    }
+    for (int i = 0; i < 16; i++) {
+        sum *= sum;
+    }
+    return sum;
+}
+
+constexpr double constLog(double x) {
+    // Reduce to [0.5, 1) then ln(m) = 2 * atanh((m - 1) / (m + 1))
+    int exponent = 0;
+    while (x >= 1.0) { x *= 0.5; exponent++; }
+    while (x < 0.5) { x *= 2.0; exponent--; }
+    double y = (x - 1.0) / (x + 1.0);
+    double y2 = y * y, term = y, sum = 0.0;
+    for (int n = 1; n < 40; n += 2) {
+        sum += term / n;
+        term *= y2;
+    }
+    return 2.0 * sum + exponent * 0.69314718055994530942;
+}
+
+constexpr double constPow(double base, double exponent) {
+    return constExp(exponent * constLog(base));
+}
+
+constexpr double bestTerminalVelocity(double diameterMm) {
+    return 9.43 * (1.0 - constExp(-constPow(diameterMm / 1.77, 1.147)));
+}
+
+struct DragTable {
+    float terminal[DRAG_TABLE_SIZE + 1];    // m/s
+    float coefficient[DRAG_TABLE_SIZE + 1]; // g / Vt^2, 1/m
+
+    constexpr DragTable() : terminal(), coefficient() {
+        for (int i = 0; i <= DRAG_TABLE_SIZE; i++) {
+            double diameter = DRAG_TABLE_MAX_DIAMETER * i / DRAG_TABLE_SIZE;
+            if (diameter < DRAG_TABLE_MIN_DIAMETER) diameter = DRAG_TABLE_MIN_DIAMETER;
+            double vt = bestTerminalVelocity(diameter);
+            terminal[i] = static_cast<float>(vt);
+            coefficient[i] = static_cast<float>(9.8 / (vt * vt));
+        }
+    }
+};
+
+constexpr DragTable DRAG_TABLE{};
+
+// Sanity checks against Gunn & Kinzer (1949): 0.25 mm ~ 0.95 m/s, 2 mm ~ 6.49 m/s
+static_assert(DRAG_TABLE.terminal[8] > 0.85f && DRAG_TABLE.terminal[8] < 1.05f,
+              "drizzle terminal velocity off");
+static_assert(DRAG_TABLE.terminal[64] > 6.3f && DRAG_TABLE.terminal[64] < 6.6f,
+              "rain terminal velocity off");
+
+// Linear interpolation into one of the tables by simulation size
+inline float dragTableLookup(const float* table, float size) {
+    float x = size * DIAMETER_PER_SIZE * (DRAG_TABLE_SIZE / DRAG_TABLE_MAX_DIAMETER);
+    x = std::min(std::max(x, 0.0f), DRAG_TABLE_SIZE - 0.001f);
+    int i = static_cast<int>(x);
+    float t = x - i;
+    return table[i] + (table[i + 1] - table[i]) * t;
+}
+
+inline float terminalVelocity(float size) {
+    return dragTableLookup(DRAG_TABLE.terminal, size);
+}
+
+// g / Vt^2 for a drop of this size, the k in a = -k |v| v
+inline float dragCoefficient(float size) {
+    return dragTableLookup(DRAG_TABLE.coefficient, size);
+}
+
+#endif
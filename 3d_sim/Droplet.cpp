@@ -1,49 +1,60 @@
 #include "Droplet.h"
+#include "Drag.h"
 #include <cstdlib>
 #include <iostream>
-#include <random>
 #include <cmath>
+#include <algorithm>
+
+// Share of the along-ground impact velocity a drop keeps as it starts to slide
+const float SLIDE_RETENTION = 0.3f;
+
+// Deceleration from surface friction while sliding (m/s^2)
+const float SLIDE_FRICTION = 2.0f;
 
 Droplet::Droplet(glm::vec3 pos, glm::vec3 vel, float sz)
-    : position(pos), velocity(vel), size(sz), hasCollided(false), deformFactor(0.0f) {}
+    : position(pos), velocity(vel), size(sz), deformFactor(0.0f), wind(0.0f), stateTime(0.0f) {}
 
-void Droplet::update(float deltaTime, std::vector<Particle>& particles) {
-    // Apply gravity
-    velocity.y -= 9.8f * deltaTime;
-    
-    // Droplet deformation during fall (becomes more elongated)
-    if (velocity.y < -1.0f && !hasCollided) {
-        deformFactor = std::min(deformFactor + deltaTime * 0.5f, 0.3f);
-    }
-    
-    // Update position
-    position += velocity * deltaTime;
+template <typename Integrator>
+void Droplet::fall(float deltaTime) {
+    // Gravity plus air drag, which settles each drop at the terminal velocity for its size
+    Integrator::step(position, velocity, AirForces(wind, dragCoefficient(size)), deltaTime);
 
-    // Ground collision
-    if (position.y - size < -2.0f) {
-        position.y = -2.0f + size;
+    // Droplet deformation during fall (becomes more elongated once it's going fast)
+    float stretching = velocity.y < -1.0f ? 0.5f : 0.0f;
+    deformFactor = std::min(deformFactor + deltaTime * stretching, 0.3f);
+    stateTime += deltaTime;
+}
 
-        // Generate splash particles
-        if (!hasCollided) {
-            hasCollided = true;
-            createSplashEffect(particles);
-        }
-        
-        velocity = glm::vec3(0.0f); // Stop moving after collision
-    }
+template void Droplet::fall<ExplicitEuler>(float);
+template void Droplet::fall<SemiImplicitEuler>(float);
+template void Droplet::fall<VelocityVerlet>(float);
+
+void Droplet::impact(float groundHeight, std::vector<Particle>& particles, RandomStream& random,
+                     float splashScale, float lifetimeScale) {
+    position.y = groundHeight + size;
+
+    // Generate splash particles (uses the impact velocity)
+    createSplashEffect(particles, random, splashScale, lifetimeScale);
+
+    velocity = glm::vec3(velocity.x, 0.0f, velocity.z) * SLIDE_RETENTION;
+    deformFactor = 0.0f;
+    stateTime = 0.0f;
 }
 
-void Droplet::createSplashEffect(std::vector<Particle>& particles) {
-    // Random number generators for realistic splash
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    
+void Droplet::slide(float deltaTime) {
+    // Friction takes a fixed amount of speed per second until the drop stops
+    float speed = std::sqrt(velocity.x * velocity.x + velocity.z * velocity.z);
+    float slowed = std::max(speed - SLIDE_FRICTION * deltaTime, 0.0f);
+    velocity *= slowed / std::max(speed, 1e-6f);
+    position += velocity * deltaTime;
+    stateTime += deltaTime;
+}
+
+void Droplet::createSplashEffect(std::vector<Particle>& particles, RandomStream& random,
+                                 float splashScale, float lifetimeScale) {
     // Parameters for the splash pattern
-    const int numParticles = 60; // More particles for a better splash
-    std::normal_distribution<float> angleDistribution(0.0f, 1.0f);
-    std::lognormal_distribution<float> speedDistribution(0.5f, 0.3f);
-    std::uniform_real_distribution<float> sizeDistribution(0.02f, 0.06f); // Varied sizes
-    std::uniform_real_distribution<float> lifespanDistribution(0.5f, 2.0f); // Varied lifespans
+    const int numParticles = std::max(1, static_cast<int>(60 * splashScale + 0.5f)); // More particles for a better splash
+    const int numVertical = static_cast<int>(10 * splashScale + 0.5f);
     
     // Calculate impact velocity for splash energy
     float impactEnergy = std::min(std::abs(velocity.y) * 0.2f, 2.0f);
@@ -52,12 +63,12 @@ void Droplet::createSplashEffect(std::vector<Particle>& particles) {
     for (int i = 0; i < numParticles; i++) {
         // Angle in the horizontal plane (crown-like)
         float angle = (i / static_cast<float>(numParticles)) * 2.0f * 3.14159265359f;
-        float angleVariation = angleDistribution(gen) * 0.3f;
+        float angleVariation = random.normal() * 0.3f;
         angle += angleVariation;
         
         // Speed varies with angle to create crown shape
-        float speed = speedDistribution(gen) * impactEnergy;
-        float upwardForce = 1.0f + std::abs(angleDistribution(gen)) * 0.5f;
+        float speed = random.lognormal(0.5f, 0.3f) * impactEnergy;
+        float upwardForce = 1.0f + std::abs(random.normal()) * 0.5f;
         
         // Create velocity with crown-like shape
         glm::vec3 particleVel = glm::vec3(
@@ -74,26 +85,28 @@ void Droplet::createSplashEffect(std::vector<Particle>& particles) {
         );
         
         // Create particle with varied size and lifespan
-        float particleSize = sizeDistribution(gen);
-        float lifespan = lifespanDistribution(gen);
+        float particleSize = random.uniform(0.02f, 0.06f);
+        float lifespan = random.uniform(0.5f, 2.0f) * lifetimeScale;
         
         particles.emplace_back(particlePos, particleVel, particleSize, lifespan);
+        particles.back().wind = wind; // Until the next sampleWind pass reaches it
     }
     
     // Add a few vertical splash particles
-    for (int i = 0; i < 10; i++) {
-        float angle = angleDistribution(gen) * 3.14159265359f;
-        float speed = speedDistribution(gen) * impactEnergy * 0.8f;
+    for (int i = 0; i < numVertical; i++) {
+        float angle = random.normal() * 3.14159265359f;
+        float speed = random.lognormal(0.5f, 0.3f) * impactEnergy * 0.8f;
         
         glm::vec3 particleVel = glm::vec3(
             cos(angle) * speed * 0.2f,
-            1.5f + std::abs(angleDistribution(gen)),
+            1.5f + std::abs(random.normal()),
             sin(angle) * speed * 0.2f
         );
         
-        float particleSize = sizeDistribution(gen) * 0.8f;
-        float lifespan = lifespanDistribution(gen) * 0.8f;
+        float particleSize = random.uniform(0.02f, 0.06f) * 0.8f;
+        float lifespan = random.uniform(0.5f, 2.0f) * 0.8f * lifetimeScale;
         
         particles.emplace_back(position, particleVel, particleSize, lifespan);
+        particles.back().wind = wind;
     }
 }
\ No newline at end of file
@@ -3,21 +3,54 @@
 
 #include <glm/glm.hpp>
 #include "Particle.h"
+#include "Integrators.h"
+#include "Random.h"
 #include <vector>
 
+// Lifecycle of a drop. The state isn't stored on the drop: Simulation keeps
+// one array per state and moves drops between them in batched passes, so
+// each state's update loop runs over a contiguous array with no branches.
+//
+//   FALLING --(reaches the ground)--> IMPACTING --(splash)--> SLIDING or POOLED
+//   SLIDING --(friction stops it)--> POOLED --(soaked in)--> removed
+enum DropletState {
+    DROPLET_FALLING,
+    DROPLET_IMPACTING,
+    DROPLET_SLIDING,
+    DROPLET_POOLED
+};
+
 class Droplet {
 public:
     glm::vec3 position;
     glm::vec3 velocity;
     float size;
-    bool hasCollided;
     float deformFactor; // How much the droplet is stretched during falling
+    glm::vec3 wind;     // Local air velocity, refreshed by sampleWind
+    float stateTime;    // Seconds spent in the current state
 
     Droplet(glm::vec3 pos, glm::vec3 vel, float sz);
-    void update(float deltaTime, std::vector<Particle>& particles);
-    
+
+    // FALLING: gravity, drag and stretching, nothing else.
+    // Instantiated in Droplet.cpp for each policy in Integrators.h
+    template <typename Integrator = DefaultIntegrator>
+    void fall(float deltaTime);
+
+    // IMPACTING: settle on the ground at groundHeight and throw up the splash
+    // (shaped by draws from random, with splashScale times the usual number
+    // of particles living lifetimeScale times as long). Keeps some of the
+    // speed along the ground, which decides what comes next.
+    void impact(float groundHeight, std::vector<Particle>& particles, RandomStream& random,
+                float splashScale = 1.0f, float lifetimeScale = 1.0f);
+
+    // SLIDING: run along the ground, slowed by friction
+    void slide(float deltaTime);
+
+    bool reachedGround(float groundHeight) const { return position.y - size < groundHeight; }
+
 private:
-    void createSplashEffect(std::vector<Particle>& particles);
+    void createSplashEffect(std::vector<Particle>& particles, RandomStream& random,
+                            float splashScale, float lifetimeScale);
 };
 
 #endif
\ No newline at end of file
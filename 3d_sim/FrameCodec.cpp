@@ -0,0 +1,215 @@
+#include "FrameCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+const float UNITS_PER_METRE = 2048.0f;      // Position steps of ~0.5 mm
+const float SIZE_UNITS_PER_METRE = 4096.0f;
+const float CULL_RANGE = 15.0f;   // Half-size of the box kept around the camera (m)
+const float BEHIND_MARGIN = 1.0f; // Keep things just behind the camera, e.g. for a quick turn (m)
+
+const size_t BLOCK = 32; // Items sharing one predicted shift
+const long SEARCH = 8;   // Shifts tried either side of the previous block's
+const size_t PROBE = 4;  // Items a shift is judged on
+
+static void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static bool getVarint(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (p == end) return false;
+        uint8_t byte = *p++;
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Small magnitudes of either sign get small codes
+static uint32_t zigzag(int32_t v) {
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+    return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+}
+
+// Unsigned maths so a corrupt stream can't overflow
+static int32_t wrappingAdd(int32_t a, int32_t b) {
+    return static_cast<int32_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
+}
+
+static int32_t wrappingSub(int32_t a, int32_t b) {
+    return static_cast<int32_t>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b));
+}
+
+// The previous frame's item at index, moved into this frame's origin
+// (zero when there's no such item, which makes the delta the value itself)
+static QuantizedItem predict(const std::vector<QuantizedItem>& base, long index, const int32_t originShift[3]) {
+    QuantizedItem p = { { 0, 0, 0, 0 } };
+    if (index >= 0 && index < static_cast<long>(base.size())) {
+        p = base[index];
+        for (int c = 0; c < 3; c++) p.v[c] = wrappingAdd(p.v[c], originShift[c]);
+    }
+    return p;
+}
+
+static long chooseShift(const std::vector<QuantizedItem>& items, size_t start, const std::vector<QuantizedItem>& base,
+                        const int32_t originShift[3], long previous) {
+    size_t probeEnd = std::min(start + PROBE, items.size());
+    long best = previous;
+    int64_t bestCost = std::numeric_limits<int64_t>::max();
+    // The previous shift goes first so it wins ties
+    for (long offset = 0; offset <= 2 * SEARCH; offset++) {
+        long candidate = previous + (offset % 2 ? (offset + 1) / 2 : -(offset / 2));
+        int64_t cost = 0;
+        for (size_t i = start; i < probeEnd; i++) {
+            QuantizedItem p = predict(base, static_cast<long>(i) + candidate, originShift);
+            for (int c = 0; c < 4; c++) cost += std::llabs(static_cast<int64_t>(items[i].v[c]) - p.v[c]);
+        }
+        if (cost < bestCost) {
+            bestCost = cost;
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+// Count, then per block the change in shift followed by each item's deltas
+static void encodeList(const std::vector<QuantizedItem>& items, const std::vector<QuantizedItem>& base,
+                       const int32_t originShift[3], std::vector<uint8_t>& out) {
+    putVarint(out, static_cast<uint32_t>(items.size()));
+    long shift = 0;
+    for (size_t start = 0; start < items.size(); start += BLOCK) {
+        long chosen = chooseShift(items, start, base, originShift, shift);
+        putVarint(out, zigzag(static_cast<int32_t>(chosen - shift)));
+        shift = chosen;
+
+        size_t end = std::min(start + BLOCK, items.size());
+        for (size_t i = start; i < end; i++) {
+            QuantizedItem p = predict(base, static_cast<long>(i) + shift, originShift);
+            for (int c = 0; c < 4; c++) putVarint(out, zigzag(wrappingSub(items[i].v[c], p.v[c])));
+        }
+    }
+}
+
+static bool decodeList(const uint8_t*& p, const uint8_t* end, const std::vector<QuantizedItem>& base,
+                       const int32_t originShift[3], std::vector<QuantizedItem>& items) {
+    uint32_t count = 0;
+    // Every item takes at least 4 bytes, which bounds a corrupt count
+    if (!getVarint(p, end, count) || count > static_cast<size_t>(end - p) / 4) return false;
+    items.resize(count);
+
+    long shift = 0;
+    for (size_t start = 0; start < count; start += BLOCK) {
+        uint32_t change = 0;
+        if (!getVarint(p, end, change)) return false;
+        shift += unzigzag(change);
+
+        size_t blockEnd = std::min(start + BLOCK, static_cast<size_t>(count));
+        for (size_t i = start; i < blockEnd; i++) {
+            QuantizedItem prediction = predict(base, static_cast<long>(i) + shift, originShift);
+            for (int c = 0; c < 4; c++) {
+                uint32_t delta = 0;
+                if (!getVarint(p, end, delta)) return false;
+                items[i].v[c] = wrappingAdd(prediction.v[c], unzigzag(delta));
+            }
+        }
+    }
+    return true;
+}
+
+FrameEncoder::FrameEncoder() : hasCamera(false), camera(0.0f), front(0.0f, 0.0f, -1.0f) {
+    baseOrigin[0] = baseOrigin[1] = baseOrigin[2] = 0;
+}
+
+void FrameEncoder::setCamera(const glm::vec3& position, const glm::vec3& direction) {
+    hasCamera = true;
+    camera = position;
+    front = direction;
+}
+
+void FrameEncoder::encode(const RenderSnapshot& snapshot, std::vector<uint8_t>& out) {
+    StreamFrameHeader header;
+    header.magic = STREAM_FRAME_MAGIC;
+    header.step = snapshot.step;
+    header.time = snapshot.time;
+    int32_t originShift[3];
+    for (int c = 0; c < 3; c++) {
+        header.origin[c] = static_cast<int32_t>(std::lround(camera[c]));
+        originShift[c] = (baseOrigin[c] - header.origin[c]) * static_cast<int32_t>(UNITS_PER_METRE);
+    }
+    glm::vec3 origin(header.origin[0], header.origin[1], header.origin[2]);
+
+    size_t headerAt = out.size();
+    out.resize(headerAt + sizeof(header));
+
+    const std::vector<glm::vec4>* lists[2] = { &snapshot.droplets, &snapshot.particles };
+    for (int list = 0; list < 2; list++) {
+        current.clear();
+        for (const auto& item : *lists[list]) {
+            glm::vec3 offset = glm::vec3(item) - camera;
+            if (std::fabs(offset.x) > CULL_RANGE || std::fabs(offset.y) > CULL_RANGE ||
+                std::fabs(offset.z) > CULL_RANGE) {
+                continue;
+            }
+            if (hasCamera && glm::dot(offset, front) < -BEHIND_MARGIN) continue;
+
+            glm::vec3 local = glm::vec3(item) - origin;
+            QuantizedItem q = { { static_cast<int32_t>(std::lround(local.x * UNITS_PER_METRE)),
+                                  static_cast<int32_t>(std::lround(local.y * UNITS_PER_METRE)),
+                                  static_cast<int32_t>(std::lround(local.z * UNITS_PER_METRE)),
+                                  static_cast<int32_t>(std::lround(item.w * SIZE_UNITS_PER_METRE)) } };
+            current.push_back(q);
+        }
+        encodeList(current, baseline[list], originShift, out);
+        baseline[list].swap(current);
+    }
+    for (int c = 0; c < 3; c++) baseOrigin[c] = header.origin[c];
+
+    header.payloadBytes = static_cast<uint32_t>(out.size() - headerAt - sizeof(header));
+    std::memcpy(&out[headerAt], &header, sizeof(header));
+}
+
+FrameDecoder::FrameDecoder() {
+    baseOrigin[0] = baseOrigin[1] = baseOrigin[2] = 0;
+}
+
+bool FrameDecoder::decode(const StreamFrameHeader& header, const uint8_t* payload, RenderSnapshot& out) {
+    if (header.magic != STREAM_FRAME_MAGIC) return false;
+    int32_t originShift[3];
+    for (int c = 0; c < 3; c++) {
+        uint32_t metres = static_cast<uint32_t>(wrappingSub(baseOrigin[c], header.origin[c]));
+        originShift[c] = static_cast<int32_t>(metres * static_cast<uint32_t>(UNITS_PER_METRE));
+    }
+
+    const uint8_t* p = payload;
+    const uint8_t* end = payload + header.payloadBytes;
+    for (int list = 0; list < 2; list++) {
+        if (!decodeList(p, end, baseline[list], originShift, current[list])) return false;
+    }
+    if (p != end) return false;
+
+    glm::vec3 origin(header.origin[0], header.origin[1], header.origin[2]);
+    std::vector<glm::vec4>* lists[2] = { &out.droplets, &out.particles };
+    for (int list = 0; list < 2; list++) {
+        lists[list]->clear();
+        for (const auto& q : current[list]) {
+            lists[list]->push_back(glm::vec4(origin + glm::vec3(q.v[0], q.v[1], q.v[2]) / UNITS_PER_METRE,
+                                             q.v[3] / SIZE_UNITS_PER_METRE));
+        }
+        baseline[list].swap(current[list]);
+    }
+    for (int c = 0; c < 3; c++) baseOrigin[c] = header.origin[c];
+    out.time = header.time;
+    out.step = header.step;
+    return true;
+}
@@ -0,0 +1,84 @@
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SimulationThread.h"
+
+// Wire format for streaming RenderSnapshots to remote viewers (see
+// StreamServer.h). Each frame is a StreamFrameHeader followed by a payload
+// of varints. Everything is in host byte order: the stream is meant for
+// machines of the same architecture on a local network.
+//
+// Frames are culled to what one viewer's camera can see, quantized relative
+// to an origin near the camera (1/2048 m positions, 1/4096 m sizes) and
+// delta-encoded against the previous frame sent to that viewer. Drops and
+// particles carry no IDs, but both lists are mostly first in, first out:
+// new items are appended and the oldest land or expire first. So each block
+// of items is predicted from the previous frame's items a few places further
+// along, with the shift picked per block by trying nearby ones. A drop that
+// moved 10 cm costs about 5 bytes instead of 16.
+const uint32_t STREAM_FRAME_MAGIC = 0x52545352;  // "RSTR"
+const uint32_t STREAM_CAMERA_MAGIC = 0x4d414352; // "RCAM"
+
+struct StreamFrameHeader {
+    uint32_t magic;
+    uint32_t payloadBytes;
+    uint32_t step;
+    float time;
+    int32_t origin[3]; // Whole metres; positions are relative to it
+};
+
+// Viewer to server: where to cull around. Sent whenever the camera moves,
+// and until the first one arrives frames are culled around the origin
+struct StreamCamera {
+    uint32_t magic;
+    float position[3];
+    float front[3];
+};
+
+// Quantized xyz + size
+struct QuantizedItem {
+    int32_t v[4];
+};
+
+// Server side, one per viewer (the baseline is whatever that viewer last got)
+class FrameEncoder {
+public:
+    FrameEncoder();
+
+    // Only cull to a box around the origin until a camera arrives
+    void setCamera(const glm::vec3& position, const glm::vec3& front);
+
+    // Append one frame (header and payload) for snapshot to out
+    void encode(const RenderSnapshot& snapshot, std::vector<uint8_t>& out);
+
+    // Items in the last frame, for compression stats
+    size_t lastItemCount() const { return baseline[0].size() + baseline[1].size(); }
+
+private:
+    bool hasCamera;
+    glm::vec3 camera;
+    glm::vec3 front;
+    std::vector<QuantizedItem> baseline[2]; // Drops, particles
+    int32_t baseOrigin[3];
+    std::vector<QuantizedItem> current;     // Scratch
+};
+
+// Viewer side
+class FrameDecoder {
+public:
+    FrameDecoder();
+
+    // Decode one whole frame into out; false (and out untouched) if it's malformed
+    bool decode(const StreamFrameHeader& header, const uint8_t* payload, RenderSnapshot& out);
+
+private:
+    std::vector<QuantizedItem> baseline[2];
+    int32_t baseOrigin[3];
+    std::vector<QuantizedItem> current[2]; // Scratch
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer() : next(0), latestMs(0.0f) {
+    for (int i = 0; i < QUERIES; i++) {
+        queries[i] = 0;
+        pending[i] = false;
+    }
+}
+
+void GpuTimer::init() {
+    glGenQueries(QUERIES, queries);
+}
+
+void GpuTimer::destroy() {
+    glDeleteQueries(QUERIES, queries);
+}
+
+void GpuTimer::begin() {
+    // Collect whatever has finished, oldest first, without waiting
+    for (int i = 0; i < QUERIES; i++) {
+        int slot = (next + i) % QUERIES;
+        if (!pending[slot]) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &nanoseconds);
+        latestMs = static_cast<float>(nanoseconds) * 1e-6f;
+        pending[slot] = false;
+    }
+
+    // Every query busy: skip timing this frame rather than stall on one
+    if (pending[next]) return;
+    glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+}
+
+void GpuTimer::end() {
+    if (pending[next]) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    pending[next] = true;
+    next = (next + 1) % QUERIES;
+}
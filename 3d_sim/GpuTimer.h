@@ -0,0 +1,31 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <GL/glew.h>
+
+// GPU time spent between begin() and end(), from GL_TIME_ELAPSED queries.
+// Results arrive a few frames late, so a small ring of queries is cycled and
+// milliseconds() is the newest one that has finished (0 until one has).
+class GpuTimer {
+public:
+    GpuTimer();
+
+    // Needs a current GL context
+    void init();
+    void destroy();
+
+    void begin();
+    void end();
+
+    float milliseconds() const { return latestMs; }
+
+private:
+    static const int QUERIES = 4;
+
+    GLuint queries[QUERIES];
+    bool pending[QUERIES];
+    int next;
+    float latestMs;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef INTEGRATORS_H
+#define INTEGRATORS_H
+
+#include <glm/glm.hpp>
+#include <cmath>
+
+// Forces on a drop in air: constant gravity plus quadratic drag against the
+// wind, a = g - k |v - w| (v - w), with k taken from the drag table.
+struct AirForces {
+    glm::vec3 gravity;
+    glm::vec3 wind;
+    float dragK;
+
+    AirForces(const glm::vec3& wind, float dragK)
+        : gravity(0.0f, -9.8f, 0.0f), wind(wind), dragK(dragK) {}
+
+    glm::vec3 acceleration(const glm::vec3& velocity) const {
+        glm::vec3 relative = velocity - wind;
+        float speed = std::sqrt(relative.x * relative.x + relative.y * relative.y + relative.z * relative.z);
+        return gravity - relative * (dragK * speed);
+    }
+};
+
+// Integrator policies. Update kernels take one of these as a template
+// parameter so the step is inlined and specialised at compile time.
+
+// Position from the old velocity, then velocity from the old acceleration.
+// Cheapest, first order, and unstable once k |v| dt approaches 1.
+struct ExplicitEuler {
+    static const char* name() { return "explicit-euler"; }
+
+    static void step(glm::vec3& position, glm::vec3& velocity, const AirForces& forces, float dt) {
+        glm::vec3 acceleration = forces.acceleration(velocity);
+        position += velocity * dt;
+        velocity += acceleration * dt;
+    }
+};
+
+// Velocity first (gravity explicit, drag backward Euler), then position from
+// the new velocity. The implicit drag v' = u - k |v'| v' dt has the closed
+// form v' = u * 2 / (1 + sqrt(1 + 4 k |u| dt)), so it is stable for any drag
+// and settles at exactly the terminal velocity. Still first order.
+struct SemiImplicitEuler {
+    static const char* name() { return "semi-implicit-euler"; }
+
+    static void step(glm::vec3& position, glm::vec3& velocity, const AirForces& forces, float dt) {
+        glm::vec3 relative = velocity + forces.gravity * dt - forces.wind;
+        float speed = std::sqrt(relative.x * relative.x + relative.y * relative.y + relative.z * relative.z);
+        float scale = 2.0f / (1.0f + std::sqrt(1.0f + 4.0f * forces.dragK * speed * dt));
+        velocity = forces.wind + relative * scale;
+        position += velocity * dt;
+    }
+};
+
+// Velocity Verlet with a predicted end-of-step velocity for the drag term.
+// Second order, two force evaluations per step.
+struct VelocityVerlet {
+    static const char* name() { return "velocity-verlet"; }
+
+    static void step(glm::vec3& position, glm::vec3& velocity, const AirForces& forces, float dt) {
+        glm::vec3 a0 = forces.acceleration(velocity);
+        position += velocity * dt + a0 * (0.5f * dt * dt);
+        glm::vec3 a1 = forces.acceleration(velocity + a0 * dt);
+        velocity += (a0 + a1) * (0.5f * dt);
+    }
+};
+
+// Integrator used by the simulation, chosen at build time:
+//   make INTEGRATOR=VelocityVerlet
+#ifndef RAIN_INTEGRATOR
+#define RAIN_INTEGRATOR SemiImplicitEuler
+#endif
+typedef RAIN_INTEGRATOR DefaultIntegrator;
+
+#endif
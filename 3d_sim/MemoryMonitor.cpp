@@ -0,0 +1,128 @@
+#include "MemoryMonitor.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+const char* const STORE_NAMES[] = { "falling", "sliding", "pooled", "particles", "compact", "emitted" };
+
+// Steady-state allocations are warned about one by one up to this many per
+// report interval, then just counted in the report
+const unsigned WARNINGS_PER_INTERVAL = 3;
+
+static std::string formatBytes(double bytes) {
+    const char* const UNITS[] = { "B", "KB", "MB", "GB" };
+    int unit = 0;
+    while (bytes >= 1024.0 && unit < 3) {
+        bytes /= 1024.0;
+        unit++;
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), unit == 0 ? "%.0f %s" : "%.1f %s", bytes, UNITS[unit]);
+    return text;
+}
+
+template <typename T>
+static void measure(const std::vector<T>& items, size_t& used, size_t& reserved) {
+    used = items.size() * sizeof(T);
+    reserved = items.capacity() * sizeof(T);
+}
+
+MemoryMonitor::MemoryMonitor(const char* label, unsigned warmupSteps, unsigned reportInterval)
+    : label(label), warmupSteps(warmupSteps), reportInterval(std::max(1u, reportInterval)),
+      steps(0), started(false), steadyAllocatingSteps(0), unreported(0) {
+    std::memset(&last, 0, sizeof(last));
+    std::memset(&interval, 0, sizeof(interval));
+    std::memset(stores, 0, sizeof(stores));
+}
+
+void MemoryMonitor::measureStores(const Simulation& sim) {
+    measure(sim.droplets, stores[0].used, stores[0].reserved);
+    measure(sim.sliding, stores[1].used, stores[1].reserved);
+    measure(sim.pooled, stores[2].used, stores[2].reserved);
+    measure(sim.particles, stores[3].used, stores[3].reserved);
+    stores[4].used = sim.compact.size() * sizeof(CompactParticle);
+    stores[4].reserved = sim.compact.capacity() * sizeof(CompactParticle);
+    measure(sim.emitted, stores[5].used, stores[5].reserved);
+    for (int s = 0; s < STORE_COUNT; s++) {
+        stores[s].peak = std::max(stores[s].peak, stores[s].reserved);
+    }
+}
+
+void MemoryMonitor::endStep(const Simulation& sim) {
+    AllocCounts now = threadAllocCounts();
+    if (!started) {
+        // Nothing to diff the first step against; it's in the warm-up anyway
+        last = now;
+        started = true;
+    }
+
+    uint64_t stepCount = 0, stepBytes = 0;
+    AllocCounts step;
+    for (int s = 0; s < ALLOC_SUBSYSTEM_COUNT; s++) {
+        step.count[s] = now.count[s] - last.count[s];
+        step.bytes[s] = now.bytes[s] - last.bytes[s];
+        interval.count[s] += step.count[s];
+        interval.bytes[s] += step.bytes[s];
+        stepCount += step.count[s];
+        stepBytes += step.bytes[s];
+    }
+    last = now;
+    steps++;
+    measureStores(sim);
+
+    if (steps > warmupSteps && stepCount > 0) {
+        steadyAllocatingSteps++;
+        if (unreported < WARNINGS_PER_INTERVAL) {
+            std::cerr << "WARNING::ALLOC::STEADY_STATE: [" << label << "] step " << sim.stepCount
+                      << " allocated " << stepCount << " blocks, " << formatBytes(static_cast<double>(stepBytes)) << " (";
+            const char* separator = "";
+            for (int s = 0; s < ALLOC_SUBSYSTEM_COUNT; s++) {
+                if (step.count[s] == 0) continue;
+                std::cerr << separator << ALLOC_SUBSYSTEM_NAMES[s] << " " << step.count[s];
+                separator = ", ";
+            }
+            std::cerr << ")" << std::endl;
+        }
+        unreported++;
+    }
+
+    if (steps % reportInterval == 0) {
+        report();
+    }
+}
+
+void MemoryMonitor::report() {
+    uint64_t count = 0, bytes = 0;
+    for (int s = 0; s < ALLOC_SUBSYSTEM_COUNT; s++) {
+        count += interval.count[s];
+        bytes += interval.bytes[s];
+    }
+
+    std::cout << "[" << label << "] steps " << steps - reportInterval + 1 << "-" << steps << ": ";
+    if (allocStatsEnabled()) {
+        std::cout << count << " allocations, " << formatBytes(static_cast<double>(bytes))
+                  << "  heap live " << formatBytes(static_cast<double>(heapLiveBytes()))
+                  << " peak " << formatBytes(static_cast<double>(heapPeakBytes())) << std::endl;
+        for (int s = 0; s < ALLOC_SUBSYSTEM_COUNT; s++) {
+            if (interval.count[s] == 0) continue;
+            std::cout << "  " << ALLOC_SUBSYSTEM_NAMES[s] << ": " << interval.count[s] << " allocations, "
+                      << formatBytes(static_cast<double>(interval.bytes[s])) << std::endl;
+        }
+        if (unreported > WARNINGS_PER_INTERVAL) {
+            std::cout << "  " << unreported << " steps allocated after warm-up" << std::endl;
+        }
+    } else {
+        std::cout << "allocation counts need a make ALLOC_STATS=1 build" << std::endl;
+    }
+
+    for (int s = 0; s < STORE_COUNT; s++) {
+        std::cout << "  " << STORE_NAMES[s] << ": " << formatBytes(static_cast<double>(stores[s].used))
+                  << " used of " << formatBytes(static_cast<double>(stores[s].reserved))
+                  << " reserved, peak " << formatBytes(static_cast<double>(stores[s].peak)) << std::endl;
+    }
+
+    std::memset(&interval, 0, sizeof(interval));
+    unreported = 0;
+}
@@ -0,0 +1,57 @@
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include <cstddef>
+#include "AllocStats.h"
+#include "Simulation.h"
+
+// Per-step memory report for the thread that steps a Simulation
+// (--alloc-stats). Call endStep after every step, on that thread. It takes
+// the step's allocations from the thread's counters (ALLOC_STATS builds
+// only; see AllocStats.h) and the size of each of the simulation's stores,
+// and:
+//  - warns when a step allocates once warmupSteps have passed, by which
+//    point every vector should have grown to the capacity it needs
+//  - every reportInterval steps prints the interval's allocations by
+//    subsystem, the heap's live and peak bytes, and each store's used,
+//    reserved (capacity) and peak reserved bytes
+class MemoryMonitor {
+public:
+    explicit MemoryMonitor(const char* label, unsigned warmupSteps = 600, unsigned reportInterval = 600);
+
+    void endStep(const Simulation& sim);
+
+    // Leave the thread's allocations since the last endStep out of the next
+    // step, for a harness's own bookkeeping between steps
+    void skipSinceLastStep() { last = threadAllocCounts(); }
+
+    // Steps after the warm-up that allocated
+    unsigned allocatingSteps() const { return steadyAllocatingSteps; }
+
+private:
+    enum { STORE_COUNT = 6 };
+
+    struct Store {
+        size_t used;
+        size_t reserved;
+        size_t peak;
+    };
+
+    void measureStores(const Simulation& sim);
+    void report();
+
+    const char* label;
+    unsigned warmupSteps;
+    unsigned reportInterval;
+    unsigned steps;
+    bool started;
+
+    AllocCounts last;     // Thread totals at the end of the previous step
+    AllocCounts interval; // Allocations since the last report
+    unsigned steadyAllocatingSteps;
+    unsigned unreported;  // Steady-state allocating steps not warned about individually
+
+    Store stores[STORE_COUNT];
+};
+
+#endif
@@ -2,6 +2,8 @@
 #define PARTICLE_H
 
 #include <glm/glm.hpp>
+#include "Drag.h"
+#include "Integrators.h"
 
 struct Particle {
     glm::vec3 position;
@@ -10,17 +12,16 @@ struct Particle {
     float life;       // Remaining lifetime of the particle
     float maxLife;    // Original lifetime (for fade calculations)
     float alpha;      // Transparency
+    glm::vec3 wind;   // Local air velocity, refreshed by sampleWind
     
     Particle(glm::vec3 pos, glm::vec3 vel, float sz, float lifespan)
-        : position(pos), velocity(vel), size(sz), life(lifespan), maxLife(lifespan), alpha(0.9f) {}
+        : position(pos), velocity(vel), size(sz), life(lifespan), maxLife(lifespan), alpha(0.9f), wind(0.0f) {}
         
     // Update particle and return true if still alive
+    template <typename Integrator = DefaultIntegrator>
     bool update(float deltaTime) {
-        position += velocity * deltaTime;
-        velocity.y -= 9.8f * deltaTime; // Gravity
-        
-        // Slow down due to air resistance
-        velocity *= (1.0f - 0.3f * deltaTime);
+        // Gravity, and air resistance slowing it down
+        Integrator::step(position, velocity, AirForces(wind, dragCoefficient(size)), deltaTime);
         
         // Update lifetime
         life -= deltaTime;
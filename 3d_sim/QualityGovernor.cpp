@@ -0,0 +1,99 @@
+#include "QualityGovernor.h"
+#include <algorithm>
+#include <cstdio>
+
+// Full quality first. Each step down turns one or two knobs by one notch,
+// starting with the ones that are hardest to see.
+const float NO_LOD = 1e9f;
+const QualityLevel LADDER[] = {
+    //  LOD (m)  lifetime  splash  spawn
+    { NO_LOD,   1.0f,     1.0f,   1.0f  },
+    { 8.0f,     1.0f,     1.0f,   1.0f  },
+    { 4.0f,     1.0f,     1.0f,   1.0f  },
+    { 4.0f,     0.75f,    1.0f,   1.0f  },
+    { 4.0f,     0.75f,    0.75f,  1.0f  },
+    { 2.0f,     0.6f,     0.75f,  1.0f  },
+    { 2.0f,     0.6f,     0.5f,   1.0f  },
+    { 0.0f,     0.5f,     0.5f,   0.75f },
+    { 0.0f,     0.5f,     0.35f,  0.5f  },
+    { 0.0f,     0.5f,     0.25f,  0.35f },
+};
+const int LEVELS = sizeof(LADDER) / sizeof(LADDER[0]);
+
+const float SMOOTHING = 0.1f;        // Weight of the newest frame in the averages
+const float DOWNGRADE_SECONDS = 0.5f;
+const float UPGRADE_LOAD = 0.7f;     // Share of budget below which quality can rise
+const float UPGRADE_SECONDS = 3.0f;
+const float SETTLE_SECONDS = 1.5f;   // Particles already in flight take a while to reflect a change
+
+QualityGovernor::QualityGovernor(float frameBudgetMs, float stepBudgetMs)
+    : frameBudgetMs(frameBudgetMs), stepBudgetMs(stepBudgetMs), renderAverage(0.0f), stepAverage(0.0f),
+      measured(false), current(0), overSince(-1.0f), underSince(-1.0f), settleUntil(0.0f) {}
+
+const QualityLevel& QualityGovernor::settings() const {
+    return LADDER[current];
+}
+
+static void describeKnob(std::string& out, const char* name, float from, float to, const char* unit) {
+    if (from == to) return;
+    char text[96];
+    if (from >= NO_LOD) {
+        std::snprintf(text, sizeof(text), "%s%s off -> %g%s", out.empty() ? "" : ", ", name, to, unit);
+    } else if (to >= NO_LOD) {
+        std::snprintf(text, sizeof(text), "%s%s %g%s -> off", out.empty() ? "" : ", ", name, from, unit);
+    } else {
+        std::snprintf(text, sizeof(text), "%s%s %g%s -> %g%s", out.empty() ? "" : ", ", name, from, unit, to, unit);
+    }
+    out += text;
+}
+
+bool QualityGovernor::update(float renderMs, float stepMs, float now) {
+    if (!measured) {
+        renderAverage = renderMs;
+        stepAverage = stepMs;
+        measured = true;
+    } else {
+        renderAverage += (renderMs - renderAverage) * SMOOTHING;
+        stepAverage += (stepMs - stepAverage) * SMOOTHING;
+    }
+    float load = std::max(renderAverage / frameBudgetMs, stepAverage / stepBudgetMs);
+
+    // Track how long load has been on either side of the thresholds
+    if (load > 1.0f) {
+        if (overSince < 0.0f) overSince = now;
+    } else {
+        overSince = -1.0f;
+    }
+    if (load < UPGRADE_LOAD) {
+        if (underSince < 0.0f) underSince = now;
+    } else {
+        underSince = -1.0f;
+    }
+
+    if (now < settleUntil) return false;
+
+    int next = current;
+    if (overSince >= 0.0f && now - overSince >= DOWNGRADE_SECONDS && current + 1 < LEVELS) {
+        next = current + 1;
+    } else if (underSince >= 0.0f && now - underSince >= UPGRADE_SECONDS && current > 0) {
+        next = current - 1;
+    }
+    if (next == current) return false;
+
+    const QualityLevel& from = LADDER[current];
+    const QualityLevel& to = LADDER[next];
+    char header[128];
+    std::snprintf(header, sizeof(header), "quality level %d -> %d (render %.1f ms of %.1f, step %.1f ms of %.1f): ",
+                  current, next, renderAverage, frameBudgetMs, stepAverage, stepBudgetMs);
+    std::string knobs;
+    describeKnob(knobs, "LOD distance", from.lodDistance, to.lodDistance, " m");
+    describeKnob(knobs, "particle lifetime", from.lifetimeScale, to.lifetimeScale, "x");
+    describeKnob(knobs, "splash particles", from.splashScale, to.splashScale, "x");
+    describeKnob(knobs, "rain density", from.spawnScale, to.spawnScale, "x");
+    change = header + knobs;
+
+    current = next;
+    settleUntil = now + SETTLE_SECONDS;
+    overSince = underSince = -1.0f;
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+#include <string>
+
+// One setting of every knob the governor turns
+struct QualityLevel {
+    float lodDistance;   // Drops and particles further than this get the low-poly mesh (m)
+    float lifetimeScale; // Splash particle lifetime multiplier
+    float splashScale;   // Share of the usual particles per splash
+    float spawnScale;    // Share of the usual rain density
+};
+
+// Holds a frame budget by stepping through a fixed ladder of QualityLevels,
+// cheapest visual loss first (mesh LOD, then particle lifetime, splash size
+// and last of all rain density).
+//
+// Each frame it's given the render time and the latest simulation step time
+// and smooths both. Load is whichever is further over its budget: the frame
+// budget for rendering, the simulation's timestep for stepping. Hysteresis
+// keeps it from oscillating: quality drops one level after load has stayed
+// over budget for DOWNGRADE_SECONDS, rises one level only after it has
+// stayed under UPGRADE_LOAD of budget for UPGRADE_SECONDS, and nothing
+// changes for SETTLE_SECONDS after a move while the new level takes effect.
+class QualityGovernor {
+public:
+    QualityGovernor(float frameBudgetMs, float stepBudgetMs);
+
+    // Call once per frame with the current time in seconds. Returns true when
+    // the level changed; describeChange() then says which knobs moved.
+    bool update(float renderMs, float stepMs, float now);
+
+    const QualityLevel& settings() const;
+    int level() const { return current; }
+    const std::string& describeChange() const { return change; }
+
+private:
+    float frameBudgetMs;
+    float stepBudgetMs;
+    float renderAverage;
+    float stepAverage;
+    bool measured;
+
+    int current;
+    float overSince;   // When load went over budget (-1 if it isn't)
+    float underSince;  // When load went under the upgrade threshold (-1 if it isn't)
+    float settleUntil;
+    std::string change;
+};
+
+#endif
@@ -0,0 +1,218 @@
+#include "RainGauge.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+static std::atomic<unsigned> nextGaugeId(1);
+
+GaugeAccumulator::GaugeAccumulator(size_t cells)
+    : impacts(cells, 0), volume(cells, 0.0f), splashSum(cells, 0.0f), splashMax(cells, 0.0f),
+      outside(0), splashTotal(0.0), splashSquares(0.0) {
+    // Every cell fits without reallocating, so recording never allocates
+    touched.reserve(cells);
+    std::memset(speedHistogram, 0, sizeof(speedHistogram));
+}
+
+void GaugeAccumulator::record(size_t cell, float volumeMm3, float splashRadius) {
+    if (impacts[cell]++ == 0) touched.push_back(static_cast<uint32_t>(cell));
+    volume[cell] += volumeMm3;
+    splashSum[cell] += splashRadius;
+    splashMax[cell] = std::max(splashMax[cell], splashRadius);
+}
+
+void GaugeAccumulator::mergeInto(GaugeAccumulator& total) {
+    for (uint32_t cell : touched) {
+        if (total.impacts[cell] == 0) total.touched.push_back(cell);
+        total.impacts[cell] += impacts[cell];
+        total.volume[cell] += volume[cell];
+        total.splashSum[cell] += splashSum[cell];
+        total.splashMax[cell] = std::max(total.splashMax[cell], splashMax[cell]);
+        impacts[cell] = 0;
+        volume[cell] = splashSum[cell] = splashMax[cell] = 0.0f;
+    }
+    touched.clear();
+
+    for (int bin = 0; bin < GAUGE_SPEED_BINS; bin++) {
+        total.speedHistogram[bin] += speedHistogram[bin];
+        speedHistogram[bin] = 0;
+    }
+    total.outside += outside;
+    total.splashTotal += splashTotal;
+    total.splashSquares += splashSquares;
+    outside = 0;
+    splashTotal = splashSquares = 0.0;
+}
+
+RainGauge::RainGauge(glm::vec2 origin, float cellSize, int cellsX, int cellsZ)
+    : origin(origin), cellSize(cellSize), invCellSize(1.0f / cellSize), cellsX(cellsX), cellsZ(cellsZ),
+      id(nextGaugeId.fetch_add(1)), merged(static_cast<size_t>(cellsX) * cellsZ), exportEvery(0),
+      stepsInInterval(0), binary(false), allImpacts(0), allVolume(0.0) {}
+
+RainGauge::~RainGauge() {
+    close();
+    for (GaugeAccumulator* accumulator : accumulators) delete accumulator;
+}
+
+GaugeAccumulator& RainGauge::local() {
+    // Each thread remembers its accumulator for the gauge it last recorded
+    // into, so only a thread's first impact (or a switch of gauge) locks
+    thread_local unsigned cachedGauge = 0;
+    thread_local GaugeAccumulator* cached = NULL;
+    if (cachedGauge == id) return *cached;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::thread::id self = std::this_thread::get_id();
+    cached = NULL;
+    for (GaugeAccumulator* accumulator : accumulators) {
+        if (accumulator->owner == self) cached = accumulator;
+    }
+    if (!cached) {
+        cached = new GaugeAccumulator(static_cast<size_t>(cellsX) * cellsZ);
+        cached->owner = self;
+        accumulators.push_back(cached);
+    }
+    cachedGauge = id;
+    return *cached;
+}
+
+void RainGauge::recordImpact(const glm::vec3& position, float speed, float diameterMm, float splashRadius) {
+    GaugeAccumulator& accumulator = local();
+    int bin = std::min(static_cast<int>(speed / GAUGE_SPEED_BIN_WIDTH), GAUGE_SPEED_BINS - 1);
+    accumulator.speedHistogram[std::max(bin, 0)]++;
+    accumulator.splashTotal += splashRadius;
+    accumulator.splashSquares += static_cast<double>(splashRadius) * splashRadius;
+
+    float gx = (position.x - origin.x) * invCellSize;
+    float gz = (position.z - origin.y) * invCellSize;
+    if (!(gx >= 0.0f && gz >= 0.0f && gx < cellsX && gz < cellsZ)) {
+        accumulator.outside++;
+        return;
+    }
+    size_t cell = static_cast<size_t>(gz) * cellsX + static_cast<size_t>(gx);
+    float volumeMm3 = 0.5235988f * diameterMm * diameterMm * diameterMm; // pi/6 d^3
+    accumulator.record(cell, volumeMm3, splashRadius);
+}
+
+bool RainGauge::open(const std::string& prefix, bool binaryFormat, int interval) {
+    close();
+    binary = binaryFormat;
+    if (binary) {
+        cellsFile.open(prefix + ".bin", std::ios::binary);
+        if (!cellsFile) {
+            std::cerr << "ERROR::GAUGE::CANNOT_WRITE: " << prefix << ".bin" << std::endl;
+            return false;
+        }
+        RainGaugeFileHeader header;
+        std::memcpy(header.magic, "RGAU", 4);
+        header.version = 1;
+        header.cellsX = cellsX;
+        header.cellsZ = cellsZ;
+        header.originX = origin.x;
+        header.originZ = origin.y;
+        header.cellSize = cellSize;
+        header.speedBins = GAUGE_SPEED_BINS;
+        header.speedBinWidth = GAUGE_SPEED_BIN_WIDTH;
+        cellsFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    } else {
+        cellsFile.open(prefix + "_cells.csv");
+        summaryFile.open(prefix + "_summary.csv");
+        if (!cellsFile || !summaryFile) {
+            std::cerr << "ERROR::GAUGE::CANNOT_WRITE: " << prefix << "_cells.csv / _summary.csv" << std::endl;
+            cellsFile.close();
+            summaryFile.close();
+            return false;
+        }
+        cellsFile << "step,time,x,z,impacts,volume_mm3,depth_mm,splash_mean_m,splash_max_m\n";
+        summaryFile << "step,time,steps,impacts,outside,volume_mm3,depth_mm,splash_mean_m,splash_std_m";
+        for (int bin = 0; bin < GAUGE_SPEED_BINS; bin++) {
+            summaryFile << ",speed_" << bin * GAUGE_SPEED_BIN_WIDTH << (bin + 1 == GAUGE_SPEED_BINS ? "_up" : "");
+        }
+        summaryFile << "\n";
+    }
+    exportEvery = std::max(interval, 1);
+    stepsInInterval = 0;
+    return true;
+}
+
+void RainGauge::close() {
+    if (exportEvery > 0) {
+        std::cout << "rain gauge: " << allImpacts << " impacts, " << allVolume / 1000.0 << " ml" << std::endl;
+    }
+    if (cellsFile.is_open()) cellsFile.close();
+    if (summaryFile.is_open()) summaryFile.close();
+    exportEvery = 0;
+}
+
+void RainGauge::endStep(unsigned step, float time) {
+    // Nobody is recording now, so reading the other threads' accumulators is safe
+    for (GaugeAccumulator* accumulator : accumulators) {
+        for (int bin = 0; bin < GAUGE_SPEED_BINS; bin++) allImpacts += accumulator->speedHistogram[bin];
+        for (uint32_t cell : accumulator->touched) allVolume += accumulator->volume[cell];
+        accumulator->mergeInto(merged);
+    }
+
+    if (exportEvery > 0 && ++stepsInInterval >= exportEvery) {
+        writeInterval(step, time);
+    }
+}
+
+void RainGauge::writeInterval(unsigned step, float time) {
+    float cellArea = cellSize * cellSize * 1e6f; // mm^2
+    uint64_t impacts = 0;
+    double volume = 0.0;
+    for (uint32_t cell : merged.touched) {
+        impacts += merged.impacts[cell];
+        volume += merged.volume[cell];
+    }
+    uint64_t recorded = impacts + merged.outside;
+    double splashMean = recorded ? merged.splashTotal / recorded : 0.0;
+    double splashVariance = recorded ? merged.splashSquares / recorded - splashMean * splashMean : 0.0;
+
+    if (binary) {
+        RainGaugeRecordHeader header;
+        header.step = step;
+        header.time = time;
+        header.steps = static_cast<uint32_t>(stepsInInterval);
+        header.outside = merged.outside;
+        std::memcpy(header.speedHistogram, merged.speedHistogram, sizeof(header.speedHistogram));
+        cellsFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // Mean splash radius per cell rather than the sum
+        for (uint32_t cell : merged.touched) merged.splashSum[cell] /= merged.impacts[cell];
+        size_t cells = merged.impacts.size();
+        cellsFile.write(reinterpret_cast<const char*>(merged.impacts.data()), cells * sizeof(uint32_t));
+        cellsFile.write(reinterpret_cast<const char*>(merged.volume.data()), cells * sizeof(float));
+        cellsFile.write(reinterpret_cast<const char*>(merged.splashSum.data()), cells * sizeof(float));
+        cellsFile.write(reinterpret_cast<const char*>(merged.splashMax.data()), cells * sizeof(float));
+        cellsFile.flush();
+    } else {
+        // Cells in row-major order so files diff cleanly between runs
+        std::sort(merged.touched.begin(), merged.touched.end());
+        for (uint32_t cell : merged.touched) {
+            uint32_t count = merged.impacts[cell];
+            cellsFile << step << ',' << time << ',' << cell % cellsX << ',' << cell / cellsX << ',' << count << ','
+                      << merged.volume[cell] << ',' << merged.volume[cell] / cellArea << ','
+                      << merged.splashSum[cell] / count << ',' << merged.splashMax[cell] << '\n';
+        }
+        double depth = volume / (cellArea * merged.impacts.size());
+        summaryFile << step << ',' << time << ',' << stepsInInterval << ',' << impacts << ',' << merged.outside << ','
+                    << volume << ',' << depth << ',' << splashMean << ',' << std::sqrt(std::max(splashVariance, 0.0));
+        for (int bin = 0; bin < GAUGE_SPEED_BINS; bin++) summaryFile << ',' << merged.speedHistogram[bin];
+        summaryFile << '\n';
+        cellsFile.flush();
+        summaryFile.flush();
+    }
+
+    // Start the next interval
+    for (uint32_t cell : merged.touched) {
+        merged.impacts[cell] = 0;
+        merged.volume[cell] = merged.splashSum[cell] = merged.splashMax[cell] = 0.0f;
+    }
+    merged.touched.clear();
+    std::memset(merged.speedHistogram, 0, sizeof(merged.speedHistogram));
+    merged.outside = 0;
+    merged.splashTotal = merged.splashSquares = 0.0;
+    stepsInInterval = 0;
+}
@@ -0,0 +1,111 @@
+#ifndef RAIN_GAUGE_H
+#define RAIN_GAUGE_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int GAUGE_SPEED_BINS = 24;
+const float GAUGE_SPEED_BIN_WIDTH = 0.5f; // m/s; the last bin takes everything faster
+
+// Ground impacts recorded by one thread since the last merge (or, for the
+// gauge's own copy, since the last export). Cells with impacts are listed in
+// touched, so merging and resetting cost the impacts rather than the grid.
+struct GaugeAccumulator {
+    std::thread::id owner;
+    std::vector<uint32_t> impacts;
+    std::vector<float> volume;     // mm^3
+    std::vector<float> splashSum;  // Sum of splash radii (m)
+    std::vector<float> splashMax;
+    std::vector<uint32_t> touched;
+    uint32_t speedHistogram[GAUGE_SPEED_BINS];
+    uint32_t outside;              // Impacts off the grid
+    double splashTotal, splashSquares;
+
+    explicit GaugeAccumulator(size_t cells);
+    void record(size_t cell, float volumeMm3, float splashRadius);
+    void mergeInto(GaugeAccumulator& total); // And reset this one
+};
+
+// Rain gauge over a fixed grid of ground cells: impact counts, deposited
+// volume and splash radius per cell, plus an impact speed histogram.
+//
+// recordImpact() is called from inside the step, once per drop that hits the
+// ground, and may come from any number of threads: each thread writes only
+// its own accumulator (found through a thread_local cache, so no locks or
+// atomics on the hot path). endStep() then folds them all into the totals;
+// it must run once per step, after every recording thread has finished with
+// that step. Every interval steps the totals are appended to the export
+// files and cleared, giving a time series:
+//
+//  - CSV: <prefix>_cells.csv has one row per cell that was hit in the
+//    interval; <prefix>_summary.csv one row per interval with the speed
+//    histogram as columns
+//  - binary: <prefix>.bin is a RainGaugeFileHeader, then per interval a
+//    RainGaugeRecordHeader followed by cells x uint32 impacts, cells x float
+//    volume (mm^3), cells x float mean splash radius and cells x float max
+//    splash radius (m), row-major with x fastest
+class RainGauge {
+public:
+    RainGauge(glm::vec2 origin, float cellSize, int cellsX, int cellsZ);
+    ~RainGauge();
+
+    // Start exporting every interval steps; false if the files can't be created
+    bool open(const std::string& prefix, bool binary, int interval);
+    void close();
+
+    // A drop hit the ground at position with speed (m/s); splashRadius is how
+    // far its splash reaches (m)
+    void recordImpact(const glm::vec3& position, float speed, float diameterMm, float splashRadius);
+
+    void endStep(unsigned step, float time);
+
+    uint64_t totalImpacts() const { return allImpacts; }
+    double totalVolume() const { return allVolume; } // mm^3
+
+private:
+    GaugeAccumulator& local();
+    void writeInterval(unsigned step, float time);
+
+    glm::vec2 origin;
+    float cellSize;
+    float invCellSize;
+    int cellsX, cellsZ;
+    unsigned id; // Tells gauges apart in the thread_local cache
+
+    std::mutex registryMutex;
+    std::vector<GaugeAccumulator*> accumulators; // One per recording thread
+    GaugeAccumulator merged;                     // Since the last export
+
+    int exportEvery;   // Steps per interval (0 until open())
+    int stepsInInterval;
+    bool binary;
+    std::ofstream cellsFile;   // CSV cells, or the binary file
+    std::ofstream summaryFile; // CSV only
+    uint64_t allImpacts;
+    double allVolume;
+};
+
+struct RainGaugeFileHeader {
+    char magic[4];    // "RGAU"
+    uint32_t version; // 1
+    int32_t cellsX, cellsZ;
+    float originX, originZ;
+    float cellSize;   // m
+    uint32_t speedBins;
+    float speedBinWidth;
+};
+
+struct RainGaugeRecordHeader {
+    uint32_t step;
+    float time;
+    uint32_t steps;   // Steps the interval covers
+    uint32_t outside;
+    uint32_t speedHistogram[GAUGE_SPEED_BINS];
+};
+
+#endif
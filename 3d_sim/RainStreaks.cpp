@@ -0,0 +1,68 @@
+#include "RainStreaks.h"
+#include "ShaderUtils.h"
+#include <glm/gtc/type_ptr.hpp>
+
+// Box side (m), streak count and opacity per layer, nearest first. Each
+// layer covers the ones inside it too, which keeps the near rain densest.
+struct StreakLayer {
+    float size;
+    int count;
+    float opacity;
+};
+const StreakLayer LAYERS[] = {
+    { 24.0f,  6000, 0.35f },
+    { 64.0f,  8000, 0.25f },
+    { 180.0f, 12000, 0.18f },
+};
+const int LAYER_COUNT = sizeof(LAYERS) / sizeof(LAYERS[0]);
+
+RainStreaks::RainStreaks()
+    : innerRadius(5.0f), blendWidth(1.5f), groundHeight(-2.0f), ceiling(10.0f), density(1.0f),
+      wind(0.0f), shaderProgram(0), vao(0) {}
+
+bool RainStreaks::init(const char* vertexSource, const char* fragmentSource) {
+    shaderProgram = createProgram(vertexSource, fragmentSource);
+    if (!shaderProgram) return false;
+    glGenVertexArrays(1, &vao);
+    return true;
+}
+
+void RainStreaks::destroy() {
+    if (vao) glDeleteVertexArrays(1, &vao);
+    if (shaderProgram) glDeleteProgram(shaderProgram);
+    vao = shaderProgram = 0;
+}
+
+void RainStreaks::draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, float time) {
+    if (!shaderProgram || density <= 0.0f) return;
+
+    glUseProgram(shaderProgram);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform3fv(glGetUniformLocation(shaderProgram, "cameraPos"), 1, glm::value_ptr(cameraPos));
+    glUniform3fv(glGetUniformLocation(shaderProgram, "wind"), 1, glm::value_ptr(wind));
+    glUniform1f(glGetUniformLocation(shaderProgram, "time"), time);
+    glUniform1f(glGetUniformLocation(shaderProgram, "groundHeight"), groundHeight);
+    glUniform1f(glGetUniformLocation(shaderProgram, "ceiling"), ceiling);
+    glUniform1f(glGetUniformLocation(shaderProgram, "innerRadius"), innerRadius);
+    glUniform1f(glGetUniformLocation(shaderProgram, "blendWidth"), blendWidth);
+
+    // Quads face the camera from either side, and nothing should hide behind a streak
+    GLboolean culling = glIsEnabled(GL_CULL_FACE);
+    glDisable(GL_CULL_FACE);
+    glDepthMask(GL_FALSE);
+
+    glBindVertexArray(vao);
+    for (int layer = 0; layer < LAYER_COUNT; layer++) {
+        GLsizei count = static_cast<GLsizei>(LAYERS[layer].count * density);
+        if (count <= 0) continue;
+        glUniform1f(glGetUniformLocation(shaderProgram, "layerSize"), LAYERS[layer].size);
+        glUniform1f(glGetUniformLocation(shaderProgram, "opacity"), LAYERS[layer].opacity);
+        glUniform1ui(glGetUniformLocation(shaderProgram, "layerSeed"), static_cast<GLuint>(layer + 1));
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+    }
+    glBindVertexArray(0);
+
+    glDepthMask(GL_TRUE);
+    if (culling) glEnable(GL_CULL_FACE);
+}
@@ -0,0 +1,37 @@
+#ifndef RAIN_STREAKS_H
+#define RAIN_STREAKS_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Far-field rain past the simulated region: motion-blurred streaks with no
+// per-drop state at all. Each layer is one instanced draw of camera-facing
+// quads; streak_vertex.glsl places instance i by hashing i, makes it fall
+// and drift with the wind as a function of time, and wraps it inside a box
+// around the camera. Streaks stay put in world space as the camera moves.
+// Bigger layers are sparser, so the rain thins out with distance, and
+// streaks fade in where the simulated drops fade out (innerRadius).
+class RainStreaks {
+public:
+    RainStreaks();
+
+    // Needs a current GL context
+    bool init(const char* vertexSource, const char* fragmentSource);
+    void destroy();
+
+    // Blends over whatever is drawn; leaves depth writes and culling as it found them
+    void draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, float time);
+
+    float innerRadius;   // Simulated rain ends here (horizontal distance from the camera)
+    float blendWidth;    // Width of the cross-fade inside innerRadius
+    float groundHeight;
+    float ceiling;       // Streaks fall from here to the ground
+    float density;       // Share of the full streak count to draw
+    glm::vec3 wind;      // Drift and slant, e.g. the prevailing wind
+
+private:
+    GLuint shaderProgram;
+    GLuint vao; // Empty: everything comes from gl_VertexID and gl_InstanceID
+};
+
+#endif
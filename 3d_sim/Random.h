@@ -0,0 +1,40 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+// Seedable random stream for everything the simulation draws (spawn points,
+// splash shapes). The engine is std::mt19937, whose output is fixed by the
+// standard, but the std:: distributions aren't (libstdc++ and libc++ turn the
+// same engine output into different numbers), so the conversions are done
+// here. A seed then gives the same draws with any compiler and library,
+// which is what lets replay traces from different builds be compared.
+class RandomStream {
+public:
+    explicit RandomStream(uint32_t seed = 5489u) : engine(seed) {}
+
+    void seed(uint32_t value) { engine.seed(value); }
+
+    // Uniform in [0, 1) from the top 24 bits, so every value is exact in a float
+    float uniform() { return static_cast<float>(engine() >> 8) * (1.0f / 16777216.0f); }
+
+    float uniform(float low, float high) { return low + (high - low) * uniform(); }
+
+    // Standard normal by Box-Muller (one draw per call, the pair's sine half is dropped)
+    float normal() {
+        float u = 1.0f - uniform(); // (0, 1], keeps the log finite
+        float v = uniform();
+        return std::sqrt(-2.0f * std::log(u)) * std::cos(6.28318530718f * v);
+    }
+
+    float normal(float mean, float deviation) { return mean + deviation * normal(); }
+
+    float lognormal(float m, float s) { return std::exp(normal(m, s)); }
+
+private:
+    std::mt19937 engine;
+};
+
+#endif
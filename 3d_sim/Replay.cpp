@@ -0,0 +1,374 @@
+#include "Replay.h"
+#include "Simulation.h"
+#include "Integrators.h"
+#include "MemoryMonitor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <sys/stat.h>
+
+// Everything that moves, in the order it's hashed and traced
+const int BUCKETS = 4;
+const char* const BUCKET_NAMES[BUCKETS] = { "falling", "sliding", "pooled", "particles" };
+
+// Per item: position, velocity and two state values (deform and state time
+// for drops, life and size for particles)
+const int VALUES_PER_ITEM = 8;
+
+const uint32_t TRACE_VERSION = 1;
+
+struct TraceHeader {
+    char magic[4];  // "RRPL"
+    uint32_t version;
+    uint32_t seed;
+    int32_t steps;
+    float timestep;
+    int32_t checkpointInterval;
+    uint32_t compactParticles;
+    char platform[64]; // Build that wrote it, for the report
+};
+
+struct Checkpoint {
+    uint32_t step;
+    uint64_t hash;
+    uint32_t counts[BUCKETS];
+    std::vector<float> values; // VALUES_PER_ITEM per item, buckets in order
+};
+
+// FNV-1a over raw bytes
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static void appendItem(std::vector<float>& values, const glm::vec3& position, const glm::vec3& velocity,
+                       float first, float second) {
+    float item[VALUES_PER_ITEM] = { position.x, position.y, position.z,
+                                    velocity.x, velocity.y, velocity.z, first, second };
+    values.insert(values.end(), item, item + VALUES_PER_ITEM);
+}
+
+static void appendDroplets(std::vector<float>& values, const std::vector<Droplet>& droplets) {
+    for (const Droplet& droplet : droplets) {
+        appendItem(values, droplet.position, droplet.velocity, droplet.deformFactor, droplet.stateTime);
+    }
+}
+
+static Checkpoint capture(const Simulation& sim) {
+    Checkpoint checkpoint;
+    checkpoint.step = sim.stepCount;
+    checkpoint.counts[0] = static_cast<uint32_t>(sim.droplets.size());
+    checkpoint.counts[1] = static_cast<uint32_t>(sim.sliding.size());
+    checkpoint.counts[2] = static_cast<uint32_t>(sim.pooled.size());
+
+    appendDroplets(checkpoint.values, sim.droplets);
+    appendDroplets(checkpoint.values, sim.sliding);
+    appendDroplets(checkpoint.values, sim.pooled);
+    if (sim.compactParticles) {
+        for (size_t i = 0; i < sim.compact.size(); i++) {
+            appendItem(checkpoint.values, sim.compact.position(i), sim.compact.velocity(i),
+                       sim.compact.alpha(i), sim.compact.particleSize(i));
+        }
+        checkpoint.counts[3] = static_cast<uint32_t>(sim.compact.size());
+    } else {
+        for (const Particle& particle : sim.particles) {
+            appendItem(checkpoint.values, particle.position, particle.velocity, particle.life, particle.size);
+        }
+        checkpoint.counts[3] = static_cast<uint32_t>(sim.particles.size());
+    }
+
+    uint64_t hash = 14695981039346656037ull;
+    hash = hashBytes(hash, &checkpoint.step, sizeof(checkpoint.step));
+    hash = hashBytes(hash, checkpoint.counts, sizeof(checkpoint.counts));
+    hash = hashBytes(hash, checkpoint.values.data(), checkpoint.values.size() * sizeof(float));
+    checkpoint.hash = hash;
+    return checkpoint;
+}
+
+static std::string hexHash(uint64_t hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
+std::string replayPlatform(const ReplayConfig& config) {
+    std::ostringstream name;
+#if defined(__x86_64__) || defined(_M_X64)
+    name << "x86_64";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    name << "arm64";
+#else
+    name << "unknown";
+#endif
+#if defined(__clang__)
+    name << "-clang" << __clang_major__;
+#elif defined(__GNUC__)
+    name << "-gcc" << __GNUC__;
+#else
+    name << "-cc";
+#endif
+    name << "-" << DefaultIntegrator::name();
+    if (config.compactParticles) name << "-compact";
+    return name.str();
+}
+
+// The line at the top of a golden file; hashes only mean something for the
+// same scenario
+static std::string goldenScenario(const ReplayConfig& config) {
+    char text[128];
+    std::snprintf(text, sizeof(text), "seed %u steps %d timestep %.9g checkpoint %d",
+                  config.seed, config.steps, config.timestep, config.checkpointInterval);
+    return text;
+}
+
+static bool loadGolden(const std::string& path, const ReplayConfig& config, std::vector<uint64_t>& hashes) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "ERROR::REPLAY::NO_GOLDEN: " << path
+                  << " (record this platform's hashes with make golden)" << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line) && (line.empty() || line[0] == '#')) {}
+    if (line != goldenScenario(config)) {
+        std::cerr << "ERROR::REPLAY::GOLDEN_SCENARIO_MISMATCH: " << path << " has \"" << line << "\"" << std::endl;
+        return false;
+    }
+
+    unsigned step;
+    std::string hex;
+    while (file >> step >> hex) {
+        hashes.push_back(std::strtoull(hex.c_str(), NULL, 16));
+    }
+    return true;
+}
+
+static bool saveGolden(const std::string& path, const ReplayConfig& config, const std::vector<Checkpoint>& checkpoints) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "ERROR::REPLAY::CANNOT_WRITE: " << path << std::endl;
+        return false;
+    }
+    file << "# Replay checkpoint hashes for " << replayPlatform(config) << ", re-record with make golden\n";
+    file << goldenScenario(config) << "\n";
+    for (const Checkpoint& checkpoint : checkpoints) {
+        file << checkpoint.step << " " << hexHash(checkpoint.hash) << "\n";
+    }
+    return file.good();
+}
+
+static void writeCheckpoint(std::ofstream& trace, const Checkpoint& checkpoint) {
+    trace.write(reinterpret_cast<const char*>(&checkpoint.step), sizeof(checkpoint.step));
+    trace.write(reinterpret_cast<const char*>(&checkpoint.hash), sizeof(checkpoint.hash));
+    trace.write(reinterpret_cast<const char*>(checkpoint.counts), sizeof(checkpoint.counts));
+    trace.write(reinterpret_cast<const char*>(checkpoint.values.data()), checkpoint.values.size() * sizeof(float));
+}
+
+static bool loadTrace(const std::string& path, const ReplayConfig& config, std::vector<Checkpoint>& checkpoints) {
+    std::ifstream trace(path, std::ios::binary);
+    if (!trace.is_open()) {
+        std::cerr << "ERROR::REPLAY::FILE_NOT_FOUND: " << path << std::endl;
+        return false;
+    }
+
+    TraceHeader header;
+    if (!trace.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, "RRPL", 4) != 0 || header.version != TRACE_VERSION) {
+        std::cerr << "ERROR::REPLAY::BAD_TRACE: " << path << std::endl;
+        return false;
+    }
+    // Full and compact particles may be compared with each other (given a
+    // tolerance of a quantization step or so), so only the scenario has to match
+    if (header.seed != config.seed || header.timestep != config.timestep ||
+        header.checkpointInterval != config.checkpointInterval) {
+        std::cerr << "ERROR::REPLAY::TRACE_SCENARIO_MISMATCH: " << path
+                  << " was recorded with a different seed, timestep or checkpoint interval" << std::endl;
+        return false;
+    }
+    header.platform[sizeof(header.platform) - 1] = '\0';
+    std::cout << "comparing against " << path << " from " << header.platform << std::endl;
+
+    Checkpoint checkpoint;
+    while (trace.read(reinterpret_cast<char*>(&checkpoint.step), sizeof(checkpoint.step))) {
+        trace.read(reinterpret_cast<char*>(&checkpoint.hash), sizeof(checkpoint.hash));
+        trace.read(reinterpret_cast<char*>(checkpoint.counts), sizeof(checkpoint.counts));
+        size_t items = 0;
+        for (int b = 0; b < BUCKETS; b++) items += checkpoint.counts[b];
+        checkpoint.values.resize(items * VALUES_PER_ITEM);
+        if (!trace.read(reinterpret_cast<char*>(checkpoint.values.data()), checkpoint.values.size() * sizeof(float))) {
+            std::cerr << "ERROR::REPLAY::TRUNCATED: " << path << std::endl;
+            return false;
+        }
+        checkpoints.push_back(checkpoint);
+    }
+    return true;
+}
+
+// Item-by-item comparison; the step is single-threaded and keeps every
+// bucket in a fixed order, so the same index is the same drop or particle.
+// Without particles only the drop buckets, which come first, are compared
+static bool compareCheckpoint(const Checkpoint& mine, const Checkpoint& theirs, float tolerance, bool particles) {
+    int buckets = particles ? BUCKETS : BUCKETS - 1;
+    size_t compared = 0;
+    for (int b = 0; b < buckets; b++) {
+        compared += mine.counts[b];
+        if (mine.counts[b] != theirs.counts[b]) {
+            std::cerr << "ERROR::REPLAY::DIVERGED: step " << mine.step << " has " << mine.counts[b] << " "
+                      << BUCKET_NAMES[b] << " vs " << theirs.counts[b] << std::endl;
+            return false;
+        }
+    }
+
+    // Largest difference in position, velocity and state, and where it is
+    const char* const KINDS[3] = { "position", "velocity", "state" };
+    float worst[3] = { 0.0f, 0.0f, 0.0f };
+    size_t worstItem[3] = { 0, 0, 0 };
+    for (size_t v = 0; v < compared * VALUES_PER_ITEM; v++) {
+        int kind = std::min(static_cast<int>(v % VALUES_PER_ITEM) / 3, 2);
+        float difference = std::abs(mine.values[v] - theirs.values[v]);
+        if (!(difference <= worst[kind])) { // NaN counts as worst
+            worst[kind] = difference;
+            worstItem[kind] = v / VALUES_PER_ITEM;
+        }
+    }
+
+    bool passed = true;
+    for (int kind = 0; kind < 3; kind++) {
+        if (!(worst[kind] <= tolerance)) {
+            // Name the bucket and index within it
+            size_t item = worstItem[kind];
+            int bucket = 0;
+            while (bucket < BUCKETS - 1 && item >= mine.counts[bucket]) item -= mine.counts[bucket++];
+            std::cerr << "ERROR::REPLAY::DIVERGED: step " << mine.step << " " << KINDS[kind] << " of "
+                      << BUCKET_NAMES[bucket] << " " << item << " off by " << worst[kind] << std::endl;
+            passed = false;
+        }
+    }
+    std::cout << "  max difference: position " << worst[0] << "  velocity " << worst[1]
+              << "  state " << worst[2] << std::endl;
+    return passed;
+}
+
+int runReplay(const ReplayConfig& config) {
+    if (config.steps <= 0 || config.timestep <= 0.0f || config.checkpointInterval <= 0) {
+        std::cerr << "ERROR::REPLAY::BAD_CONFIG" << std::endl;
+        return 1;
+    }
+
+    // Same scene as the interactive loop, minus anything time- or run-dependent
+    Simulation sim(glm::vec2(-5.0f), glm::vec2(5.0f));
+    sim.random.seed(config.seed);
+    sim.compactParticles = config.compactParticles;
+
+    std::string platform = replayPlatform(config);
+    std::cout << "replay " << platform << "  " << goldenScenario(config) << std::endl;
+
+    std::vector<Checkpoint> reference;
+    if (!config.comparePath.empty() && !loadTrace(config.comparePath, config, reference)) {
+        return 1;
+    }
+
+    std::string goldenPath;
+    std::vector<uint64_t> golden;
+    if (!config.goldenDir.empty()) {
+        goldenPath = config.goldenDir + "/" + platform + ".txt";
+        if (config.recordGolden) {
+            mkdir(config.goldenDir.c_str(), 0755);
+        } else if (!loadGolden(goldenPath, config, golden)) {
+            return 1;
+        }
+    }
+
+    std::ofstream trace;
+    if (!config.tracePath.empty()) {
+        trace.open(config.tracePath, std::ios::binary);
+        if (!trace.is_open()) {
+            std::cerr << "ERROR::REPLAY::CANNOT_WRITE: " << config.tracePath << std::endl;
+            return 1;
+        }
+        TraceHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "RRPL", 4);
+        header.version = TRACE_VERSION;
+        header.seed = config.seed;
+        header.steps = config.steps;
+        header.timestep = config.timestep;
+        header.checkpointInterval = config.checkpointInterval;
+        header.compactParticles = config.compactParticles;
+        std::strncpy(header.platform, platform.c_str(), sizeof(header.platform) - 1);
+        trace.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    // Half the run warms up, then reports come at every checkpoint
+    MemoryMonitor memoryMonitor("replay", config.steps / 2, config.checkpointInterval);
+
+    std::vector<Checkpoint> checkpoints;
+    int failures = 0;
+    for (int step = 1; step <= config.steps; step++) {
+        sim.step(config.timestep);
+        if (config.allocStats) memoryMonitor.endStep(sim);
+        if (step % config.checkpointInterval != 0) continue;
+
+        Checkpoint checkpoint = capture(sim);
+        size_t index = checkpoints.size();
+        std::cout << "step " << checkpoint.step << "  hash " << hexHash(checkpoint.hash);
+        for (int b = 0; b < BUCKETS; b++) {
+            std::cout << "  " << BUCKET_NAMES[b] << " " << checkpoint.counts[b];
+        }
+        std::cout << std::endl;
+
+        if (trace.is_open()) {
+            writeCheckpoint(trace, checkpoint);
+        }
+        if (!config.comparePath.empty()) {
+            if (index >= reference.size() || reference[index].step != checkpoint.step) {
+                std::cerr << "ERROR::REPLAY::TRACE_TOO_SHORT: no step " << checkpoint.step
+                          << " in " << config.comparePath << std::endl;
+                failures++;
+            } else if (!compareCheckpoint(checkpoint, reference[index], config.tolerance, config.compareParticles)) {
+                failures++;
+            }
+        }
+        if (!config.goldenDir.empty() && !config.recordGolden) {
+            if (index >= golden.size()) {
+                std::cerr << "ERROR::REPLAY::GOLDEN_TOO_SHORT: no step " << checkpoint.step
+                          << " in " << goldenPath << std::endl;
+                failures++;
+            } else if (golden[index] != checkpoint.hash) {
+                std::cerr << "ERROR::REPLAY::HASH_MISMATCH: step " << checkpoint.step << " expected "
+                          << hexHash(golden[index]) << std::endl;
+                failures++;
+            }
+        }
+        checkpoints.push_back(checkpoint);
+        if (config.allocStats) memoryMonitor.skipSinceLastStep();
+    }
+
+    if (trace.is_open()) {
+        trace.close();
+        if (!trace.good()) {
+            std::cerr << "ERROR::REPLAY::CANNOT_WRITE: " << config.tracePath << std::endl;
+            failures++;
+        }
+    }
+    if (config.recordGolden) {
+        if (!saveGolden(goldenPath, config, checkpoints)) return 1;
+        std::cout << "recorded " << goldenPath << std::endl;
+    }
+
+    if (failures > 0) {
+        std::cout << "replay FAILED at " << failures << " checkpoint(s)" << std::endl;
+        return 1;
+    }
+    std::cout << "replay passed" << std::endl;
+    return 0;
+}
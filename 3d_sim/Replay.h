@@ -0,0 +1,52 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <string>
+
+// Deterministic headless run for checking that an optimisation didn't change
+// the results. The scene is the interactive one (rain over the +-5 m patch)
+// but with a fixed seed, a fixed timestep and therefore a fixed spawn
+// schedule. Every checkpointInterval steps the whole world state is hashed
+// and, depending on the options:
+//
+//  - tracePath: the state is also written to a trace file (positions and
+//    velocities of everything, plus the hash)
+//  - comparePath: the state is compared with a trace written by another
+//    build (SIMD vs scalar, another compiler or integrator) or with the
+//    other particle store, and fails if any value differs by more than
+//    tolerance. Compact particles expire on quantized lifetimes, so full
+//    against compact needs compareParticles off: only the drops match
+//  - goldenDir: the hashes are checked against (or with recordGolden,
+//    written to) goldenDir/<platform>.txt, where the platform names the
+//    architecture, compiler and integrator. Bit-exact results only hold
+//    within one platform, hence one golden file per platform.
+//
+// With none of them set it just prints the hashes.
+struct ReplayConfig {
+    uint32_t seed;
+    int steps;
+    float timestep;          // Fixed seconds per step
+    int checkpointInterval;  // Steps between hashes
+    bool compactParticles;   // Run with Simulation::compactParticles set
+    std::string tracePath;
+    std::string comparePath;
+    float tolerance;         // Largest allowed difference when comparing (m, m/s)
+    bool compareParticles;   // Compare splash particles too, not just the drops
+    std::string goldenDir;
+    bool recordGolden;
+    bool allocStats;         // Per-step allocation report, see MemoryMonitor.h
+
+    ReplayConfig()
+        : seed(1), steps(600), timestep(1.0f / 60.0f), checkpointInterval(60),
+          compactParticles(false), tolerance(1e-4f), compareParticles(true), recordGolden(false),
+          allocStats(false) {}
+};
+
+// Returns the process exit code: 0 if every check passed
+int runReplay(const ReplayConfig& config);
+
+// Name of the golden file for this build, e.g. "x86_64-gcc12-semi-implicit-euler"
+std::string replayPlatform(const ReplayConfig& config);
+
+#endif
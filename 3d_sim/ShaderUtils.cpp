@@ -2,6 +2,25 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Program binary cache file: this header, then the driver's binary blob.
+// Files are named after the key, a hash of the driver strings and sources.
+struct ProgramCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t format; // GLenum from glGetProgramBinary
+    uint32_t length;
+};
+
+static const uint32_t PROGRAM_CACHE_VERSION = 1;
 
 std::string loadShaderSource(const char* filePath) {
     std::ifstream shaderFile(filePath);
@@ -16,6 +35,28 @@ std::string loadShaderSource(const char* filePath) {
     return shaderStream.str();
 }
 
+std::string shaderSource(const char* name) {
+#ifdef SHADER_HOT_RELOAD
+    // Dev builds edit shaders in place, so the copy on disk wins
+    if (shaderSourceStamp(name) != 0) {
+        return loadShaderSource(name);
+    }
+#endif
+    for (const EmbeddedShader* shader = EMBEDDED_SHADERS; shader->name; shader++) {
+        if (std::strcmp(shader->name, name) == 0) {
+            return shader->source;
+        }
+    }
+    std::cerr << "ERROR::SHADER::NOT_EMBEDDED: " << name << std::endl;
+    return "";
+}
+
+long shaderSourceStamp(const char* name) {
+    struct stat info;
+    if (stat(name, &info) != 0) return 0;
+    return static_cast<long>(info.st_mtime);
+}
+
 GLuint compileShader(GLenum type, const GLchar* source) {
     GLuint shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, NULL);
@@ -30,4 +71,161 @@ GLuint compileShader(GLenum type, const GLchar* source) {
         return 0;
     }
     return shader;
-}
\ No newline at end of file
+}
+
+// FNV-1a, chained across strings (the terminator is hashed too so
+// "ab" + "c" and "a" + "bc" differ)
+static uint64_t hashString(uint64_t hash, const char* text) {
+    if (!text) text = "";
+    do {
+        hash ^= static_cast<unsigned char>(*text);
+        hash *= 1099511628211ull;
+    } while (*text++);
+    return hash;
+}
+
+// Where binaries go: $RAIN_SHADER_CACHE, else $XDG_CACHE_HOME/rain-it-in or
+// ~/.cache/rain-it-in. Empty if there's nowhere sensible or the driver
+// can't hand back binaries (some report zero formats).
+static const std::string& programCacheDirectory() {
+    static std::string directory;
+    static bool checked = false;
+    if (checked) return directory;
+    checked = true;
+
+    GLint formats = 0;
+    if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    if (formats <= 0) return directory;
+
+    if (const char* custom = std::getenv("RAIN_SHADER_CACHE")) {
+        directory = custom;
+    } else if (const char* xdg = std::getenv("XDG_CACHE_HOME")) {
+        directory = std::string(xdg) + "/rain-it-in";
+    } else if (const char* home = std::getenv("HOME")) {
+        mkdir((std::string(home) + "/.cache").c_str(), 0755);
+        directory = std::string(home) + "/.cache/rain-it-in";
+    }
+    if (!directory.empty()) {
+        mkdir(directory.c_str(), 0755);
+    }
+    return directory;
+}
+
+static uint64_t programCacheKey(const GLchar* vertexSource, const GLchar* fragmentSource) {
+    uint64_t key = 14695981039346656037ull;
+    key = hashString(key, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+    key = hashString(key, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    key = hashString(key, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+    key = hashString(key, vertexSource);
+    key = hashString(key, fragmentSource);
+    return key;
+}
+
+static std::string programCachePath(const std::string& directory, uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/%016llx.bin", static_cast<unsigned long long>(key));
+    return directory + name;
+}
+
+// Returns 0 if there's no usable binary (missing, stale, or the driver
+// rejects it after an update); the caller then builds from source
+static GLuint loadCachedProgram(const std::string& path, uint64_t key) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return 0;
+
+    ProgramCacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, "RSPB", 4) != 0 ||
+        header.version != PROGRAM_CACHE_VERSION || header.key != key || header.length == 0) {
+        return 0;
+    }
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size())) return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static void saveCachedProgram(GLuint program, const std::string& path, uint64_t key) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, NULL, &format, binary.data());
+
+    ProgramCacheHeader header;
+    std::memcpy(header.magic, "RSPB", 4);
+    header.version = PROGRAM_CACHE_VERSION;
+    header.key = key;
+    header.format = format;
+    header.length = static_cast<uint32_t>(length);
+
+    // Many processes may start at once: write privately, then rename into place
+    std::string tempPath = path + "." + std::to_string(getpid()) + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary);
+    if (!file.is_open()) return;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), binary.size());
+    file.close();
+    if (file.good()) {
+        std::rename(tempPath.c_str(), path.c_str());
+    } else {
+        std::remove(tempPath.c_str());
+    }
+}
+
+GLuint createProgram(const GLchar* vertexSource, const GLchar* fragmentSource) {
+    const std::string& cacheDirectory = programCacheDirectory();
+    uint64_t key = 0;
+    std::string cachePath;
+    if (!cacheDirectory.empty()) {
+        key = programCacheKey(vertexSource, fragmentSource);
+        cachePath = programCachePath(cacheDirectory, key);
+        GLuint cached = loadCachedProgram(cachePath, key);
+        if (cached) return cached;
+    }
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    if (!vertexShader || !fragmentShader) {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    if (!cachePath.empty()) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint success;
+    GLchar infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    if (!cachePath.empty()) {
+        saveCachedProgram(program, cachePath, key);
+    }
+    return program;
+}
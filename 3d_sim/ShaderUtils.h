@@ -4,10 +4,32 @@
 #include <string>
 #include <GL/glew.h>
 
+// Shader sources compiled into the binary. The table is generated by make
+// from the .glsl files (see EmbeddedShaders.cpp in the Makefile) and ends
+// with a { 0, 0 } entry.
+struct EmbeddedShader {
+    const char* name;
+    const char* source;
+};
+extern const EmbeddedShader EMBEDDED_SHADERS[];
+
 // Function to load shader source code from a file
 std::string loadShaderSource(const char* filePath);
 
+// Source for a shader by file name, e.g. "vertex_shader.glsl". Comes from the
+// embedded table, so the working directory doesn't matter; dev builds
+// (make SHADER_HOT_RELOAD=1) prefer the file on disk when there is one.
+std::string shaderSource(const char* name);
+
+// Modification time of a shader file on disk (0 if missing), for hot reload
+long shaderSourceStamp(const char* name);
+
 // Function to compile a shader
 GLuint compileShader(GLenum type, const GLchar* source);
 
-#endif
\ No newline at end of file
+// Function to compile and link a vertex + fragment program (0 on failure).
+// Linked programs are cached with glGetProgramBinary, keyed by the driver
+// and both sources, so later launches skip compiling and linking.
+GLuint createProgram(const GLchar* vertexSource, const GLchar* fragmentSource);
+
+#endif
@@ -0,0 +1,143 @@
+#include "ShadowMap.h"
+#include "ShaderUtils.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+const int SHADOW_TEXTURE_UNIT = 1;
+
+ShadowMap::ShadowMap(int size)
+    : lightDirection(0.0f, 1.0f, 0.0f), radius(5.0f), groundHeight(-2.0f), ceiling(5.0f), dropRadius(0.1f),
+      strength(0.4f), size(size), shaderProgram(0), fbo(0), depthTexture(0), vao(0), positionVBO(0),
+      lightSpace(1.0f), texelsPerMetre(1.0f) {}
+
+bool ShadowMap::init(const char* vertexSource, const char* fragmentSource) {
+    shaderProgram = createProgram(vertexSource, fragmentSource);
+    if (!shaderProgram) return false;
+
+    // Depth only, compared in the sampler so each lookup is a hardware 2x2 PCF
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    GLfloat border[] = { 1.0f, 1.0f, 1.0f, 1.0f }; // Outside the map is lit
+    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        std::cerr << "ERROR::SHADOW::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        destroy();
+        return false;
+    }
+
+    // xyz + scale per caster, straight from the snapshot
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &positionVBO);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    return true;
+}
+
+void ShadowMap::destroy() {
+    if (positionVBO) glDeleteBuffers(1, &positionVBO);
+    if (vao) glDeleteVertexArrays(1, &vao);
+    if (fbo) glDeleteFramebuffers(1, &fbo);
+    if (depthTexture) glDeleteTextures(1, &depthTexture);
+    if (shaderProgram) glDeleteProgram(shaderProgram);
+    positionVBO = vao = fbo = depthTexture = shaderProgram = 0;
+}
+
+void ShadowMap::fit(glm::vec2 centre) {
+    glm::vec3 direction = glm::normalize(lightDirection);
+    glm::vec3 up = std::fabs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 lightView = glm::lookAt(direction, glm::vec3(0.0f), up);
+
+    // Bounds of the region's box in light space
+    glm::vec3 lo(1e30f), hi(-1e30f);
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec3 world(centre.x + ((corner & 1) ? radius : -radius), (corner & 2) ? ceiling : groundHeight,
+                        centre.y + ((corner & 4) ? radius : -radius));
+        glm::vec3 p = glm::vec3(lightView * glm::vec4(world, 1.0f));
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+
+    // The box only ever translates, so its extent is fixed and snapping the
+    // corner to whole texels keeps every caster on the same texel grid
+    float extent = std::max(hi.x - lo.x, hi.y - lo.y);
+    float texel = extent / (size - 2); // A texel of slack each side for the snap
+    texelsPerMetre = 1.0f / texel;
+    float left = std::floor(lo.x / texel) * texel - texel;
+    float bottom = std::floor(lo.y / texel) * texel - texel;
+    glm::mat4 lightProjection = glm::ortho(left, left + size * texel, bottom, bottom + size * texel,
+                                           -hi.z - 1.0f, -lo.z + 1.0f);
+    lightSpace = lightProjection * lightView;
+}
+
+void ShadowMap::render(glm::vec2 centre, const std::vector<glm::vec4>& droplets,
+                       const std::vector<glm::vec4>& particles) {
+    if (!shaderProgram) return;
+    fit(centre);
+
+    // Orphan and refill: one upload of the positions the main pass already has
+    size_t count = droplets.size() + particles.size();
+    glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec4), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, droplets.size() * sizeof(glm::vec4), droplets.data());
+    glBufferSubData(GL_ARRAY_BUFFER, droplets.size() * sizeof(glm::vec4), particles.size() * sizeof(glm::vec4),
+                    particles.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLint previousProgram;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, size, size);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+
+    if (count > 0) {
+        glUseProgram(shaderProgram);
+        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "lightSpace"), 1, GL_FALSE, glm::value_ptr(lightSpace));
+        glUniform1f(glGetUniformLocation(shaderProgram, "pixelsPerUnit"), dropRadius * 2.0f * texelsPerMetre);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glBindVertexArray(vao);
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(count));
+        glBindVertexArray(0);
+        glDisable(GL_PROGRAM_POINT_SIZE);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glUseProgram(previousProgram);
+}
+
+void ShadowMap::bind(GLuint program) const {
+    glUniformMatrix4fv(glGetUniformLocation(program, "lightSpace"), 1, GL_FALSE, glm::value_ptr(lightSpace));
+    glUniform1i(glGetUniformLocation(program, "shadowMap"), SHADOW_TEXTURE_UNIT);
+    glUniform1f(glGetUniformLocation(program, "shadowStrength"), depthTexture ? strength : 0.0f);
+    glActiveTexture(GL_TEXTURE0 + SHADOW_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
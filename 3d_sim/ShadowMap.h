@@ -0,0 +1,54 @@
+#ifndef SHADOW_MAP_H
+#define SHADOW_MAP_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Shadows of the rain on the ground from the main light.
+//
+// The light is treated as distant (only its direction counts) and its
+// orthographic view is fitted around the simulated region, from the ground
+// up to the ceiling. Drops and particles are uploaded as they come in the
+// snapshot (xyz + scale) and drawn depth-only in a single GL_POINTS call:
+// seen from a distant light a sphere's shadow is a disc, so each one is a
+// point sprite (shadow_vertex.glsl) sized to cover it, with nothing per
+// vertex but its position. The ground and the puddles on it then sample
+// the map with 3x3 PCF in fragment_shader.glsl.
+//
+// The fitted view is snapped to whole texels so the shadows don't shimmer
+// while the region follows the camera.
+class ShadowMap {
+public:
+    explicit ShadowMap(int size);
+
+    // Needs a current GL context
+    bool init(const char* vertexSource, const char* fragmentSource);
+    void destroy();
+
+    // Refit around centre (x, z) and draw the casters into the map. Leaves
+    // the framebuffer, viewport and program as it found them
+    void render(glm::vec2 centre, const std::vector<glm::vec4>& droplets, const std::vector<glm::vec4>& particles);
+
+    // Point a program using fragment_shader.glsl at the map (texture unit 1)
+    void bind(GLuint program) const;
+
+    glm::vec3 lightDirection; // Towards the light
+    float radius;             // Half-width of the region to cover
+    float groundHeight;
+    float ceiling;            // Casters above this are cut off
+    float dropRadius;         // World radius per unit of snapshot scale (the mesh radius)
+    float strength;           // Share of the light a fully covered spot loses
+
+private:
+    void fit(glm::vec2 centre);
+
+    int size;
+    GLuint shaderProgram;
+    GLuint fbo, depthTexture;
+    GLuint vao, positionVBO;
+    glm::mat4 lightSpace;
+    float texelsPerMetre;
+};
+
+#endif
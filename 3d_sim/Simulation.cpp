@@ -0,0 +1,220 @@
+#include "Simulation.h"
+#include "Integrators.h"
+#include "Drag.h"
+#include "AllocStats.h"
+#include "RainGauge.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// Sliding drops slower than this come to rest as a pool (m/s)
+const float SLIDE_MIN_SPEED = 0.05f;
+
+// Move every item matching pred from one bucket to the end of another,
+// keeping the order of both
+template <typename T, typename Pred>
+static void moveIf(std::vector<T>& from, std::vector<T>& to, Pred pred) {
+    size_t kept = 0;
+    for (size_t i = 0; i < from.size(); i++) {
+        if (pred(from[i])) {
+            to.push_back(from[i]);
+        } else {
+            from[kept++] = from[i];
+        }
+    }
+    from.erase(from.begin() + kept, from.end());
+}
+
+// Wrap v into [lo, lo + size)
+static float wrapInto(float v, float lo, float size) {
+    if (v >= lo && v < lo + size) return v;
+    float t = std::fmod(v - lo, size);
+    return lo + (t < 0.0f ? t + size : t);
+}
+
+// How far out a splash lands: the mean horizontal distance its particles
+// (from first on) cover before dropping back to launch height, with drag
+// linearised as for the GPU splashes
+static float splashReach(const std::vector<Particle>& particles, size_t first, const glm::vec3& centre) {
+    if (first >= particles.size()) return 0.0f;
+    float total = 0.0f;
+    for (size_t i = first; i < particles.size(); i++) {
+        const Particle& particle = particles[i];
+        float relaxTime = terminalVelocity(particle.size) / 9.8f;
+        float flight = 2.0f * std::max(particle.velocity.y, 0.0f) / 9.8f;
+        float horizontal = std::sqrt(particle.velocity.x * particle.velocity.x + particle.velocity.z * particle.velocity.z);
+        float offset = glm::length(glm::vec2(particle.position.x - centre.x, particle.position.z - centre.z));
+        total += offset + horizontal * relaxTime * (1.0f - std::exp(-flight / relaxTime));
+    }
+    return total / (particles.size() - first);
+}
+
+Simulation::Simulation(glm::vec2 regionMin, glm::vec2 regionMax)
+    : wind(glm::vec3(regionMin.x, -2.0f, regionMin.y),
+           glm::vec3(regionMax.x - regionMin.x, 8.0f, regionMax.y - regionMin.y), 32, 16, 32),
+      compactParticles(false), compact(glm::vec3(regionMin.x, -2.0f, regionMin.y)), gpuSplashes(false),
+      gauge(NULL), regionMin(regionMin), regionMax(regionMax),
+      // One drop per 60 Hz frame, the rate the interactive loop always ran at
+      spawnInterval(1.0f / 60.0f), spawnHeight(5.0f), dropSize(0.3f),
+      groundHeight(-2.0f), poolSoakTime(0.5f), splashScale(1.0f), lifetimeScale(1.0f), spawnScale(1.0f),
+      random(std::random_device()()), time(0.0f), stepCount(0), spawnTimer(0.0f) {}
+
+void Simulation::reset() {
+    droplets.clear();
+    impacting.clear();
+    sliding.clear();
+    pooled.clear();
+    particles.clear();
+    compact.clear();
+    emitted.clear();
+    spawnTimer = 0.0f;
+    time = 0.0f;
+    stepCount = 0;
+}
+
+void Simulation::recentre(glm::vec2 centre) {
+    glm::vec2 size = regionMax - regionMin;
+    glm::vec3 cell = wind.spacing();
+    glm::vec2 newMin(std::floor((centre.x - size.x * 0.5f) / cell.x + 0.5f) * cell.x,
+                     std::floor((centre.y - size.y * 0.5f) / cell.z + 0.5f) * cell.z);
+    if (newMin == regionMin) return;
+
+    regionMin = newMin;
+    regionMax = newMin + size;
+    wind.moveOrigin(regionMin.x, regionMin.y);
+    compact.rebase((regionMin + regionMax) * 0.5f);
+
+    for (auto& droplet : droplets) {
+        droplet.position.x = wrapInto(droplet.position.x, regionMin.x, size.x);
+        droplet.position.z = wrapInto(droplet.position.z, regionMin.y, size.y);
+    }
+
+    glm::vec2 lo = regionMin, hi = regionMax;
+    auto outside = [lo, hi](const Droplet& droplet) {
+        return droplet.position.x < lo.x || droplet.position.x > hi.x ||
+               droplet.position.z < lo.y || droplet.position.z > hi.y;
+    };
+    sliding.erase(std::remove_if(sliding.begin(), sliding.end(), outside), sliding.end());
+    pooled.erase(std::remove_if(pooled.begin(), pooled.end(), outside), pooled.end());
+}
+
+void Simulation::step(float deltaTime) {
+    time += deltaTime;
+    stepCount++;
+
+    // Spawn new droplets at the configured rate
+    ALLOC_SCOPE(ALLOC_SPAWN);
+    spawnTimer += deltaTime * spawnScale;
+    while (spawnTimer >= spawnInterval) {
+        float randomX = random.uniform(regionMin.x, regionMax.x);
+        float randomZ = random.uniform(regionMin.y, regionMax.y);
+        droplets.emplace_back(glm::vec3(randomX, spawnHeight, randomZ), glm::vec3(0.0f), dropSize);
+        spawnTimer -= spawnInterval;
+    }
+
+    ALLOC_SCOPE(ALLOC_WIND);
+    wind.update(time);
+
+    // There are far more splash particles than drops, so each step
+    // only refreshes the wind for a quarter of them
+    sampleWind(wind, droplets);
+    if (!compactParticles) {
+        sampleWind(wind, particles, 4, stepCount);
+    }
+
+    // Falling: the hot path, integration only
+    ALLOC_SCOPE(ALLOC_DROPLETS);
+    for (auto& droplet : droplets) {
+        droplet.fall<DefaultIntegrator>(deltaTime);
+    }
+    float ground = groundHeight;
+    moveIf(droplets, impacting, [ground](const Droplet& droplet) {
+        return droplet.reachedGround(ground);
+    });
+
+    // Impacting: splash, then slide off or pool depending on the speed left
+    {
+        ALLOC_SCOPE(ALLOC_SPLASHES);
+        for (auto& droplet : impacting) {
+            if (!gauge) {
+                droplet.impact(groundHeight, particles, random, splashScale, lifetimeScale);
+                continue;
+            }
+            float speed = glm::length(droplet.velocity);
+            size_t firstParticle = particles.size();
+            droplet.impact(groundHeight, particles, random, splashScale, lifetimeScale);
+            gauge->recordImpact(droplet.position, speed, droplet.size * DIAMETER_PER_SIZE,
+                                splashReach(particles, firstParticle, droplet.position));
+        }
+    }
+    if (gauge) {
+        gauge->endStep(stepCount, time);
+    }
+    moveIf(impacting, sliding, [](const Droplet& droplet) {
+        return glm::length(droplet.velocity) >= SLIDE_MIN_SPEED;
+    });
+    pooled.insert(pooled.end(), impacting.begin(), impacting.end());
+    impacting.clear();
+
+    // Sliding: friction until they stop
+    for (auto& droplet : sliding) {
+        droplet.slide(deltaTime);
+    }
+    moveIf(sliding, pooled, [](const Droplet& droplet) {
+        return glm::length(droplet.velocity) < SLIDE_MIN_SPEED;
+    });
+
+    // Pooled: wait to soak in, then go
+    for (auto& droplet : pooled) {
+        droplet.stateTime += deltaTime;
+    }
+    float soakTime = poolSoakTime;
+    pooled.erase(std::remove_if(pooled.begin(), pooled.end(),
+    [soakTime](const Droplet& droplet) {
+        return droplet.stateTime >= soakTime;
+    }),
+    pooled.end());
+
+    ALLOC_SCOPE(ALLOC_PARTICLES);
+    if (gpuSplashes) {
+        // Splashes are cosmetic; the GPU takes them from their birth state
+        for (const auto& particle : particles) {
+            float terminal = terminalVelocity(particle.size);
+            SplashSpawn spawn;
+            spawn.position = particle.position;
+            spawn.birthTime = time;
+            spawn.velocity = particle.velocity;
+            spawn.lifespan = particle.maxLife;
+            spawn.drift = particle.wind - glm::vec3(0.0f, terminal, 0.0f);
+            spawn.relaxTime = terminal / 9.8f;
+            spawn.size = particle.size;
+            emitted.push_back(spawn);
+        }
+        particles.clear();
+        return;
+    }
+
+    if (compactParticles) {
+        // New splashes join the compact store, which samples its own wind
+        for (const auto& particle : particles) {
+            compact.add(particle);
+        }
+        particles.clear();
+        compact.update<DefaultIntegrator>(deltaTime, wind, stepCount);
+        return;
+    }
+
+    // Update particles for droplet
+    for (auto& particle : particles) {
+        DefaultIntegrator::step(particle.position, particle.velocity,
+                                AirForces(particle.wind, dragCoefficient(particle.size)), deltaTime);
+        particle.life -= deltaTime; // Decrease lifetime
+    }
+
+    // Remove dead particles
+    particles.erase(std::remove_if(particles.begin(), particles.end(),
+    [](const Particle& particle) {
+        return particle.life <= 0.0f;
+    }),
+    particles.end());
+}
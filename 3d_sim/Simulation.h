@@ -0,0 +1,95 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "Droplet.h"
+#include "Particle.h"
+#include "WindField.h"
+#include "CompactParticles.h"
+#include "Random.h"
+
+class RainGauge;
+
+// Birth state of a splash particle handed to the GPU (see SplashRing.h).
+// Everything after birth is evaluated in closed form in the vertex shader,
+// with drag linearised so velocity relaxes exponentially towards drift
+// (the wind plus the drop's terminal fall speed) over relaxTime = Vt / g.
+struct SplashSpawn {
+    glm::vec3 position;
+    float birthTime;
+    glm::vec3 velocity;
+    float lifespan;
+    glm::vec3 drift;
+    float relaxTime;
+    float size;
+};
+
+// Headless simulation state: the drops, their splash particles and the wind.
+// Rendering only reads droplets/particles; anything that steps the world
+// (the interactive loop, tile workers) goes through step().
+class Simulation {
+public:
+    // Rain spawns uniformly over [regionMin, regionMax] on the ground plane (x, z)
+    Simulation(glm::vec2 regionMin, glm::vec2 regionMax);
+
+    void step(float deltaTime);
+    void reset();
+
+    // Move the region, keeping its size, so it's centred near (x, z) on the
+    // ground plane; used to keep the simulated rain around a moving camera.
+    // Moves snap to the wind grid spacing. Falling drops left outside wrap
+    // round to the side that just came into range, so the rain keeps its
+    // density with no gap while new drops fall; sliding and pooled drops
+    // left behind are removed, and splash particles are left to expire.
+    // The compact particle store's tile range is rebased to follow.
+    void recentre(glm::vec2 centre);
+
+    // Drops bucketed by lifecycle state (see DropletState in Droplet.h).
+    // droplets holds the falling ones, which is nearly all of them.
+    std::vector<Droplet> droplets;
+    std::vector<Droplet> impacting; // Only non-empty during step()
+    std::vector<Droplet> sliding;
+    std::vector<Droplet> pooled;
+    std::vector<Particle> particles;
+    WindField wind;
+
+    // With compactParticles set, splash particles live in compact (16 bytes
+    // each, see CompactParticles.h) and particles only holds new ones until
+    // the end of the step
+    bool compactParticles;
+    CompactParticles compact;
+
+    // With gpuSplashes set, splash particles aren't simulated at all: each
+    // step's new ones are appended to emitted (cleared by whoever uploads them)
+    bool gpuSplashes;
+    std::vector<SplashSpawn> emitted;
+
+    // When set, every drop that hits the ground is recorded (see RainGauge.h)
+    RainGauge* gauge;
+
+    glm::vec2 regionMin, regionMax;
+    float spawnInterval; // Seconds between new drops over the whole region
+    float spawnHeight;
+    float dropSize;
+    float groundHeight;
+    float poolSoakTime;  // Seconds a pooled drop lingers before soaking in
+
+    // Quality knobs, all 1 at full quality (see QualityGovernor.h)
+    float splashScale;   // Share of the usual particles per splash
+    float lifetimeScale; // Splash particle lifetime multiplier
+    float spawnScale;    // Share of the usual rain density
+
+    // Every random draw in step() comes from here. Seeded from
+    // std::random_device; reseed it for a run that can be replayed exactly
+    // (see Replay.h). reset() leaves it alone.
+    RandomStream random;
+
+    float time;          // Simulated seconds since the last reset
+    unsigned stepCount;
+
+private:
+    float spawnTimer;
+};
+
+#endif
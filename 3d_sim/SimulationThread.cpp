@@ -0,0 +1,123 @@
+#include "SimulationThread.h"
+#include <chrono>
+
+// Steps we are allowed to run back to back to catch up after a hiccup;
+// beyond that the sim drops time rather than spiralling
+const int MAX_CATCH_UP_STEPS = 4;
+
+SimulationThread::SimulationThread(Simulation& sim, float timestep)
+    : sim(sim), timestep(timestep), running(false), paused(false), resetRequested(false),
+      memoryMonitor(NULL), lastStepMs(0.0f), qualityChanged(false),
+      pendingFocus(0.0f), focusChanged(false) {}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::start() {
+    if (running.load()) return;
+    running.store(true);
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+    running.store(false);
+    if (thread.joinable()) thread.join();
+}
+
+void SimulationThread::run() {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<float>(timestep));
+    Clock::time_point next = Clock::now();
+
+    while (running.load()) {
+        if (resetRequested.exchange(false)) {
+            sim.reset();
+            {
+                std::lock_guard<std::mutex> lock(splashMutex);
+                pendingSplashes.clear();
+            }
+            publish();
+        }
+
+        if (qualityChanged.exchange(false)) {
+            std::lock_guard<std::mutex> lock(qualityMutex);
+            sim.splashScale = pendingQuality.splashScale;
+            sim.lifetimeScale = pendingQuality.lifetimeScale;
+            sim.spawnScale = pendingQuality.spawnScale;
+        }
+
+        if (focusChanged.exchange(false)) {
+            std::lock_guard<std::mutex> lock(focusMutex);
+            sim.recentre(pendingFocus);
+        }
+
+        if (!paused.load()) {
+            Clock::time_point stepStart = Clock::now();
+            sim.step(timestep);
+            lastStepMs.store(std::chrono::duration<float, std::milli>(Clock::now() - stepStart).count());
+            publish();
+            if (memoryMonitor) memoryMonitor->endStep(sim);
+        }
+
+        next += period;
+        Clock::time_point now = Clock::now();
+        if (now - next > period * MAX_CATCH_UP_STEPS) {
+            next = now; // Too far behind, skip ahead
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void SimulationThread::setQuality(const QualityLevel& level) {
+    std::lock_guard<std::mutex> lock(qualityMutex);
+    pendingQuality = level;
+    qualityChanged.store(true);
+}
+
+void SimulationThread::setFocus(glm::vec2 centre) {
+    std::lock_guard<std::mutex> lock(focusMutex);
+    pendingFocus = centre;
+    focusChanged.store(true);
+}
+
+void SimulationThread::takeSplashes(std::vector<SplashSpawn>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lock(splashMutex);
+    out.swap(pendingSplashes);
+}
+
+void SimulationThread::publish() {
+    // Only render data goes into the snapshot; the vectors keep their capacity
+    // between uses, so steady-state publishing doesn't allocate
+    ALLOC_SCOPE(ALLOC_PUBLISH);
+    RenderSnapshot& out = snapshots.writeBuffer();
+    out.droplets.clear();
+    out.puddles.clear();
+    out.particles.clear();
+
+    for (const auto& droplet : sim.droplets) {
+        out.droplets.push_back(glm::vec4(droplet.position, droplet.size));
+    }
+    for (const auto& droplet : sim.sliding) {
+        out.droplets.push_back(glm::vec4(droplet.position, droplet.size));
+    }
+    for (const auto& droplet : sim.pooled) {
+        out.puddles.push_back(glm::vec4(droplet.position, droplet.size));
+    }
+    for (const auto& particle : sim.particles) {
+        out.particles.push_back(glm::vec4(particle.position, particle.size));
+    }
+    sim.compact.appendRenderData(out.particles);
+    if (!sim.emitted.empty()) {
+        std::lock_guard<std::mutex> lock(splashMutex);
+        pendingSplashes.insert(pendingSplashes.end(), sim.emitted.begin(), sim.emitted.end());
+        sim.emitted.clear();
+    }
+
+    out.time = sim.time;
+    out.step = sim.stepCount;
+
+    snapshots.publish();
+}
@@ -0,0 +1,88 @@
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Simulation.h"
+#include "TripleBuffer.h"
+#include "MemoryMonitor.h"
+#include "QualityGovernor.h"
+
+// What the renderer needs from one simulation step: xyz + size per drop
+// (falling or sliding), per puddle (pooled drops) and per splash particle.
+// Streamed frames (FrameCodec.h) leave the puddles out
+struct RenderSnapshot {
+    std::vector<glm::vec4> droplets;
+    std::vector<glm::vec4> puddles;
+    std::vector<glm::vec4> particles;
+    float time;
+    unsigned step;
+
+    RenderSnapshot() : time(0.0f), step(0) {}
+};
+
+// Steps a Simulation on its own thread at a fixed rate and publishes a
+// RenderSnapshot after every step. The render thread never touches the
+// Simulation directly; it reads snapshots and posts pause/reset requests.
+class SimulationThread {
+public:
+    SimulationThread(Simulation& sim, float timestep);
+    ~SimulationThread();
+
+    void start();
+    void stop();
+
+    // Report each step's allocations and store sizes (set before start())
+    void setMemoryMonitor(MemoryMonitor* monitor) { memoryMonitor = monitor; }
+
+    void togglePause() { paused.store(!paused.load()); }
+    void requestReset() { resetRequested.store(true); }
+
+    // Render thread: swap in the latest snapshot if there is one
+    bool acquire() { return snapshots.acquire(); }
+    const RenderSnapshot& snapshot() const { return snapshots.readBuffer(); }
+
+    // Render thread: knobs to apply from the next step on
+    void setQuality(const QualityLevel& level);
+
+    // Render thread: centre the simulated region near (x, z) from the next
+    // step on (see Simulation::recentre)
+    void setFocus(glm::vec2 centre);
+
+    // Wall time the latest step took
+    float stepMilliseconds() const { return lastStepMs.load(); }
+
+    // Render thread: move out every splash emitted since the last call. Unlike
+    // snapshots these can't be skipped, so they queue behind a mutex instead
+    void takeSplashes(std::vector<SplashSpawn>& out);
+
+private:
+    void run();
+    void publish();
+
+    Simulation& sim;
+    float timestep;
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<bool> paused;
+    std::atomic<bool> resetRequested;
+    TripleBuffer<RenderSnapshot> snapshots;
+    MemoryMonitor* memoryMonitor;
+    std::atomic<float> lastStepMs;
+
+    std::mutex qualityMutex;
+    QualityLevel pendingQuality;
+    std::atomic<bool> qualityChanged;
+
+    std::mutex focusMutex;
+    glm::vec2 pendingFocus;
+    std::atomic<bool> focusChanged;
+
+    std::mutex splashMutex;
+    std::vector<SplashSpawn> pendingSplashes;
+};
+
+#endif
@@ -0,0 +1,297 @@
+#include "Skybox.h"
+#include "ShaderUtils.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <turbojpeg.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Same order as GL_TEXTURE_CUBE_MAP_POSITIVE_X + i
+static const char* FACE_NAMES[6] = { "right", "left", "top", "bottom", "front", "back" };
+
+// Pre-decoded cache: this header, then six faceSize x faceSize RGB faces.
+// Each source JPEG's size and mtime are stored so edits invalidate it.
+struct SkyboxCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t faceSize;
+    uint32_t reserved;
+    uint64_t sourceStamps[6];
+};
+
+static const uint32_t SKYBOX_CACHE_VERSION = 1;
+
+static uint64_t sourceStamp(const std::string& path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return 0;
+    return (static_cast<uint64_t>(info.st_size) << 32) ^ static_cast<uint64_t>(info.st_mtime);
+}
+
+static std::string facePath(const std::string& directory, int face) {
+    return directory + "/" + FACE_NAMES[face] + ".jpg";
+}
+
+// Decode a JPEG to RGB and centre-crop it to a square (cubemap faces must be)
+static bool decodeFace(const std::string& path, std::vector<unsigned char>& pixels, int& size) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "ERROR::SKYBOX::FILE_NOT_FOUND: " << path << std::endl;
+        return false;
+    }
+    std::vector<unsigned char> jpeg((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    tjhandle decoder = tjInitDecompress();
+    int width, height, subsampling, colorspace;
+    if (!decoder || tjDecompressHeader3(decoder, jpeg.data(), jpeg.size(), &width, &height, &subsampling, &colorspace) != 0) {
+        std::cerr << "ERROR::SKYBOX::BAD_JPEG: " << path << std::endl;
+        if (decoder) tjDestroy(decoder);
+        return false;
+    }
+
+    std::vector<unsigned char> rgb(static_cast<size_t>(width) * height * 3);
+    int result = tjDecompress2(decoder, jpeg.data(), jpeg.size(), rgb.data(), width, 0, height, TJPF_RGB, TJFLAG_FASTDCT);
+    tjDestroy(decoder);
+    if (result != 0) {
+        std::cerr << "ERROR::SKYBOX::DECODE_FAILED: " << path << std::endl;
+        return false;
+    }
+
+    size = std::min(width, height);
+    int offsetX = (width - size) / 2, offsetY = (height - size) / 2;
+    pixels.resize(static_cast<size_t>(size) * size * 3);
+    for (int row = 0; row < size; row++) {
+        std::memcpy(&pixels[static_cast<size_t>(row) * size * 3],
+                    &rgb[(static_cast<size_t>(row + offsetY) * width + offsetX) * 3],
+                    static_cast<size_t>(size) * 3);
+    }
+    return true;
+}
+
+Skybox::Skybox()
+    : stopRequested(false), cacheMapping(nullptr), cacheBytes(0), program(0), cubemap(0), pbo(0),
+      vao(0), vbo(0), faceSize(0), uploadedFaces(0), placeholderColor(0.0f) {}
+
+Skybox::~Skybox() {
+    stopRequested.store(true);
+    if (loader.joinable()) loader.join();
+    if (cacheMapping) munmap(cacheMapping, cacheBytes);
+}
+
+void Skybox::destroy() {
+    stopRequested.store(true);
+    if (loader.joinable()) loader.join();
+
+    glDeleteProgram(program);
+    glDeleteTextures(1, &cubemap);
+    glDeleteBuffers(1, &pbo);
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+}
+
+bool Skybox::init(const char* vertexSource, const char* fragmentSource, const glm::vec3& placeholder) {
+    placeholderColor = placeholder;
+    program = createProgram(vertexSource, fragmentSource);
+    if (!program) return false;
+
+    // Unit cube, 36 vertices, faces wound to be seen from the inside
+    const GLfloat cubeVertices[] = {
+        -1,  1, -1,  -1, -1, -1,   1, -1, -1,   1, -1, -1,   1,  1, -1,  -1,  1, -1,
+        -1, -1,  1,  -1, -1, -1,  -1,  1, -1,  -1,  1, -1,  -1,  1,  1,  -1, -1,  1,
+         1, -1, -1,   1, -1,  1,   1,  1,  1,   1,  1,  1,   1,  1, -1,   1, -1, -1,
+        -1, -1,  1,  -1,  1,  1,   1,  1,  1,   1,  1,  1,   1, -1,  1,  -1, -1,  1,
+        -1,  1, -1,   1,  1, -1,   1,  1,  1,   1,  1,  1,  -1,  1,  1,  -1,  1, -1,
+        -1, -1, -1,  -1, -1,  1,   1, -1, -1,   1, -1, -1,  -1, -1,  1,   1, -1,  1
+    };
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    glGenTextures(1, &cubemap);
+    glGenBuffers(1, &pbo);
+    return true;
+}
+
+void Skybox::startLoading(const std::string& directory, const std::string& cachePath) {
+    loader = std::thread(&Skybox::load, this, directory, cachePath);
+}
+
+void Skybox::load(std::string directory, std::string cachePath) {
+    if (mapCache(cachePath, directory)) return;
+
+    // One decode thread per face; each face is published as soon as it's done
+    std::vector<std::thread> decoders;
+    for (int i = 0; i < 6; i++) {
+        decoders.emplace_back([this, i, &directory]() {
+            if (stopRequested.load()) return;
+            Face& face = faces[i];
+            if (decodeFace(facePath(directory, i), face.decoded, face.size)) {
+                face.pixels = face.decoded.data();
+                face.ready.store(true, std::memory_order_release);
+            }
+        });
+    }
+    for (auto& decoder : decoders) decoder.join();
+
+    writeCache(cachePath, directory);
+}
+
+bool Skybox::mapCache(const std::string& cachePath, const std::string& directory) {
+    int fd = open(cachePath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    SkyboxCacheHeader header;
+    bool valid = fstat(fd, &info) == 0 &&
+                 read(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header)) &&
+                 std::memcmp(header.magic, "RSKY", 4) == 0 &&
+                 header.version == SKYBOX_CACHE_VERSION &&
+                 static_cast<size_t>(info.st_size) == sizeof(header) + 6ull * header.faceSize * header.faceSize * 3;
+    for (int i = 0; valid && i < 6; i++) {
+        valid = header.sourceStamps[i] == sourceStamp(facePath(directory, i));
+    }
+    if (!valid) {
+        close(fd);
+        return false;
+    }
+
+    cacheBytes = info.st_size;
+    cacheMapping = mmap(nullptr, cacheBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (cacheMapping == MAP_FAILED) {
+        cacheMapping = nullptr;
+        return false;
+    }
+
+    // Faces point straight into the mapping; pages come in as they're uploaded
+    const unsigned char* data = static_cast<const unsigned char*>(cacheMapping) + sizeof(header);
+    size_t faceBytes = static_cast<size_t>(header.faceSize) * header.faceSize * 3;
+    for (int i = 0; i < 6; i++) {
+        faces[i].pixels = data + i * faceBytes;
+        faces[i].size = header.faceSize;
+        faces[i].ready.store(true, std::memory_order_release);
+    }
+    return true;
+}
+
+void Skybox::writeCache(const std::string& cachePath, const std::string& directory) {
+    SkyboxCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "RSKY", 4);
+    header.version = SKYBOX_CACHE_VERSION;
+    header.faceSize = faces[0].size;
+    for (int i = 0; i < 6; i++) {
+        if (!faces[i].ready.load() || faces[i].size != faces[0].size) return; // Nothing consistent to cache
+        header.sourceStamps[i] = sourceStamp(facePath(directory, i));
+    }
+
+    // Write to a temporary file and rename so a reader never maps a partial cache
+    std::string tempPath = cachePath + ".tmp";
+    std::ofstream cache(tempPath, std::ios::binary);
+    if (!cache.is_open()) return;
+    cache.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int i = 0; i < 6; i++) {
+        cache.write(reinterpret_cast<const char*>(faces[i].pixels), faces[i].decoded.size());
+    }
+    cache.close();
+    if (cache.good()) {
+        rename(tempPath.c_str(), cachePath.c_str());
+    } else {
+        unlink(tempPath.c_str());
+    }
+}
+
+void Skybox::update() {
+    if (uploadedFaces == 6) return;
+
+    for (int i = 0; i < 6; i++) {
+        Face& face = faces[i];
+        if (face.uploaded || !face.ready.load(std::memory_order_acquire)) continue;
+
+        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        // First face fixes the size: allocate every face, filled with the clear colour
+        if (faceSize == 0) {
+            faceSize = face.size;
+            std::vector<unsigned char> fill(static_cast<size_t>(faceSize) * faceSize * 3);
+            for (size_t p = 0; p < fill.size(); p += 3) {
+                fill[p + 0] = static_cast<unsigned char>(placeholderColor.x * 255.0f);
+                fill[p + 1] = static_cast<unsigned char>(placeholderColor.y * 255.0f);
+                fill[p + 2] = static_cast<unsigned char>(placeholderColor.z * 255.0f);
+            }
+            for (int f = 0; f < 6; f++) {
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, 0, GL_RGB8, faceSize, faceSize, 0,
+                             GL_RGB, GL_UNSIGNED_BYTE, fill.data());
+            }
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        }
+
+        if (face.size == faceSize) {
+            // Stream through the PBO: orphan it, copy in, and let the driver
+            // do the texture transfer without stalling this thread
+            size_t bytes = static_cast<size_t>(faceSize) * faceSize * 3;
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+            void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if (mapped) {
+                std::memcpy(mapped, face.pixels, bytes);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, faceSize, faceSize,
+                                GL_RGB, GL_UNSIGNED_BYTE, (void*)0);
+            }
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        } else {
+            std::cerr << "ERROR::SKYBOX::FACE_SIZE_MISMATCH: " << FACE_NAMES[i] << std::endl;
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        face.uploaded = true;
+        uploadedFaces++;
+        break; // One face per frame keeps the upload cost off any single frame
+    }
+
+    // Decoded copies are no longer needed once the loader is done with them
+    if (uploadedFaces == 6 && loader.joinable()) {
+        loader.join();
+        for (Face& face : faces) {
+            std::vector<unsigned char>().swap(face.decoded);
+        }
+    }
+}
+
+void Skybox::draw(const glm::mat4& view, const glm::mat4& projection) {
+    if (faceSize == 0) return; // Nothing has arrived yet; the clear colour stands in
+
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_FALSE);
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1i(glGetUniformLocation(program, "skybox"), 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+}
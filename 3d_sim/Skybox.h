@@ -0,0 +1,72 @@
+#ifndef SKYBOX_H
+#define SKYBOX_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Cubemap sky that streams in after startup.
+//
+// startLoading() returns immediately: a loader thread either maps a
+// pre-decoded cache file or decodes the six JPEG faces in parallel (one
+// thread per face, centre-cropped to squares) and then writes that cache for
+// next time. Each frame, update() uploads at most one finished face through a
+// pixel buffer object; faces that aren't ready yet show the clear colour.
+class Skybox {
+public:
+    Skybox();
+    ~Skybox();
+
+    // Needs a current GL context. Returns false if the sky program won't build.
+    bool init(const char* vertexSource, const char* fragmentSource, const glm::vec3& placeholderColor);
+
+    // Faces are <directory>/{right,left,top,bottom,front,back}.jpg
+    void startLoading(const std::string& directory, const std::string& cachePath);
+
+    // Upload the next decoded face, if any (GL thread, once per frame)
+    void update();
+
+    // Draw after the opaque geometry: depth sits on the far plane, so covered
+    // pixels are rejected by the depth test before shading
+    void draw(const glm::mat4& view, const glm::mat4& projection);
+
+    bool ready() const { return uploadedFaces == 6; }
+
+    // Stop loading and free the GL objects (call before the context goes away)
+    void destroy();
+
+private:
+    struct Face {
+        std::vector<unsigned char> decoded; // Owned pixels when decoded here
+        const unsigned char* pixels;        // RGB, size x size (decoded or in the cache mapping)
+        int size;
+        std::atomic<bool> ready;
+        bool uploaded;
+
+        Face() : pixels(nullptr), size(0), ready(false), uploaded(false) {}
+    };
+
+    void load(std::string directory, std::string cachePath);
+    bool mapCache(const std::string& cachePath, const std::string& directory);
+    void writeCache(const std::string& cachePath, const std::string& directory);
+
+    Face faces[6];
+    std::thread loader;
+    std::atomic<bool> stopRequested;
+
+    void* cacheMapping;
+    size_t cacheBytes;
+
+    GLuint program;
+    GLuint cubemap;
+    GLuint pbo;
+    GLuint vao, vbo;
+    int faceSize; // 0 until the first face arrives and storage is allocated
+    int uploadedFaces;
+    glm::vec3 placeholderColor;
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include "SplashRing.h"
+#include "ShaderUtils.h"
+#include <algorithm>
+#include <cstddef>
+
+// Instances are read straight out of the SplashSpawn array
+static_assert(sizeof(SplashSpawn) == 13 * sizeof(float), "SplashSpawn must stay tightly packed");
+
+SplashRing::SplashRing(size_t capacity)
+    : capacity(capacity), head(0), tail(0), count(0),
+      shaderProgram(0), vao(0), instanceVBO(0), meshIndexCount(0) {}
+
+bool SplashRing::init(const char* vertexSource, const char* fragmentSource,
+                      GLuint meshVBO, GLuint meshEBO, GLsizei indexCount) {
+    shaderProgram = createProgram(vertexSource, fragmentSource);
+    if (!shaderProgram) return false;
+    meshIndexCount = indexCount;
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &instanceVBO);
+    glBindVertexArray(vao);
+
+    // Per-vertex: the shared droplet mesh
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshEBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+
+    // Per-instance: the ring itself, allocated once at full size
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(SplashSpawn), NULL, GL_DYNAMIC_DRAW);
+    for (GLuint attribute = 2; attribute <= 5; attribute++) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    setInstanceOffset(0);
+
+    glBindVertexArray(0);
+    return true;
+}
+
+// GL 3.3 has no base-instance draws, so a range that doesn't start at slot 0
+// is drawn by pointing the instance attributes at its first slot
+void SplashRing::setInstanceOffset(size_t first) {
+    const GLsizei stride = sizeof(SplashSpawn);
+    const size_t base = first * sizeof(SplashSpawn);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SplashSpawn, position)));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SplashSpawn, velocity)));
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SplashSpawn, drift)));
+    glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SplashSpawn, size)));
+}
+
+void SplashRing::upload(const std::vector<SplashSpawn>& spawns) {
+    if (spawns.empty()) return;
+
+    // More than the ring holds at once: only the newest fit
+    const SplashSpawn* data = spawns.data();
+    size_t n = spawns.size();
+    if (n > capacity) {
+        data += n - capacity;
+        n = capacity;
+    }
+    while (capacity - count < n) {
+        dropOldestBatch();
+    }
+
+    // Write at the head, wrapping around the end of the buffer if needed
+    size_t first = std::min(n, capacity - head);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, head * sizeof(SplashSpawn), first * sizeof(SplashSpawn), data);
+    if (n > first) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (n - first) * sizeof(SplashSpawn), data + first);
+    }
+
+    float expiry = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        expiry = std::max(expiry, data[i].birthTime + data[i].lifespan);
+    }
+
+    head = (head + n) % capacity;
+    count += n;
+    batches.push_back({ head, expiry });
+}
+
+void SplashRing::dropOldestBatch() {
+    if (batches.empty()) return;
+    size_t released = (batches.front().end + capacity - tail) % capacity;
+    if (released == 0) released = count; // The batch filled the whole ring
+    tail = batches.front().end;
+    count -= released;
+    batches.pop_front();
+}
+
+void SplashRing::retire(float time) {
+    while (!batches.empty() && batches.front().expiry <= time) {
+        dropOldestBatch();
+    }
+}
+
+void SplashRing::clear() {
+    head = tail = count = 0;
+    batches.clear();
+}
+
+void SplashRing::destroy() {
+    glDeleteProgram(shaderProgram);
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void SplashRing::draw(float time) {
+    if (count == 0) return;
+
+    glUniform1f(glGetUniformLocation(shaderProgram, "time"), time);
+    glBindVertexArray(vao);
+
+    // Live slots are [tail, tail + count), which may wrap past the end
+    size_t first = std::min(count, capacity - tail);
+    setInstanceOffset(tail);
+    glDrawElementsInstanced(GL_TRIANGLES, meshIndexCount, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(first));
+    if (count > first) {
+        setInstanceOffset(0);
+        glDrawElementsInstanced(GL_TRIANGLES, meshIndexCount, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(count - first));
+    }
+
+    glBindVertexArray(0);
+}
@@ -0,0 +1,63 @@
+#ifndef SPLASH_RING_H
+#define SPLASH_RING_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <deque>
+#include <vector>
+#include "Simulation.h"
+
+// GPU ring buffer of splash particles for Simulation::gpuSplashes.
+//
+// Each particle is uploaded once, at birth, as a SplashSpawn instance and
+// the vertex shader (splash_vertex.glsl) works out where it is from the
+// current time. Uploads are grouped into batches; a batch is retired (the
+// ring's tail moves past it) once its longest-lived particle has expired,
+// so the CPU does no per-particle work after emission.
+class SplashRing {
+public:
+    explicit SplashRing(size_t capacity);
+
+    // Needs a current GL context. meshVBO/meshEBO hold the droplet mesh
+    // (position + normal, 6 floats per vertex) drawn for every instance.
+    bool init(const char* vertexSource, const char* fragmentSource,
+              GLuint meshVBO, GLuint meshEBO, GLsizei meshIndexCount);
+
+    // Append new particles; if the ring is full the oldest batches make room
+    void upload(const std::vector<SplashSpawn>& spawns);
+
+    // Drop batches that have fully expired by this time
+    void retire(float time);
+
+    void clear();
+
+    // Free the GL objects (call before the context goes away)
+    void destroy();
+
+    // Draws with the program's uniforms as set by the caller (see program())
+    void draw(float time);
+
+    GLuint program() const { return shaderProgram; }
+    size_t size() const { return count; }
+
+private:
+    struct Batch {
+        size_t end;   // Ring slot just past the batch
+        float expiry; // Time the last of its particles dies
+    };
+
+    void setInstanceOffset(size_t first);
+    void dropOldestBatch();
+
+    size_t capacity;
+    size_t head;  // Next slot to write
+    size_t tail;  // Oldest live slot
+    size_t count; // Live slots, tail to head
+    std::deque<Batch> batches;
+
+    GLuint shaderProgram;
+    GLuint vao, instanceVBO;
+    GLsizei meshIndexCount;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "StreamClient.h"
+#include "StreamServer.h"
+#include <sys/socket.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+// Anything bigger is a corrupt header rather than a real frame
+const uint32_t MAX_FRAME_BYTES = 256u << 20;
+
+StreamClient::StreamClient() : fd(-1), running(false), live(false), cameraChanged(false) {
+    std::memset(&pendingCamera, 0, sizeof(pendingCamera));
+}
+
+StreamClient::~StreamClient() {
+    stop();
+}
+
+bool StreamClient::connect(const std::string& address) {
+    fd = connectStream(address);
+    if (fd < 0) return false;
+    signal(SIGPIPE, SIG_IGN); // A server that goes away shows up as a failed send instead
+    live.store(true);
+    return true;
+}
+
+void StreamClient::start() {
+    if (running.load() || fd < 0) return;
+    running.store(true);
+    thread = std::thread(&StreamClient::run, this);
+}
+
+void StreamClient::stop() {
+    running.store(false);
+    if (thread.joinable()) thread.join();
+    if (fd >= 0) close(fd);
+    fd = -1;
+    live.store(false);
+}
+
+void StreamClient::setCamera(const glm::vec3& position, const glm::vec3& front) {
+    std::lock_guard<std::mutex> lock(cameraMutex);
+    pendingCamera.magic = STREAM_CAMERA_MAGIC;
+    for (int c = 0; c < 3; c++) {
+        pendingCamera.position[c] = position[c];
+        pendingCamera.front[c] = front[c];
+    }
+    cameraChanged.store(true);
+}
+
+void StreamClient::run() {
+    while (running.load() && live.load()) {
+        if (cameraChanged.exchange(false)) {
+            std::lock_guard<std::mutex> lock(cameraMutex);
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&pendingCamera);
+            outgoing.insert(outgoing.end(), bytes, bytes + sizeof(pendingCamera));
+        }
+        if (!outgoing.empty()) {
+            ssize_t sent = send(fd, outgoing.data(), outgoing.size(), 0);
+            if (sent > 0) {
+                outgoing.erase(outgoing.begin(), outgoing.begin() + sent);
+            } else if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "ERROR::STREAM::SEND_FAILED: " << std::strerror(errno) << std::endl;
+                live.store(false);
+                break;
+            }
+        }
+
+        pollfd entry = { fd, POLLIN, 0 };
+        poll(&entry, 1, 10);
+        if (!receive()) live.store(false);
+    }
+}
+
+// Read what's there and publish every whole frame; false once the stream is over
+bool StreamClient::receive() {
+    unsigned char chunk[64 * 1024];
+    for (;;) {
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received > 0) {
+            incoming.insert(incoming.end(), chunk, chunk + received);
+            continue;
+        }
+        if (received == 0) {
+            std::cout << "server closed the stream" << std::endl;
+            return false;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            std::cerr << "ERROR::STREAM::RECEIVE_FAILED: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        break;
+    }
+
+    size_t used = 0;
+    while (incoming.size() - used >= sizeof(StreamFrameHeader)) {
+        StreamFrameHeader header;
+        std::memcpy(&header, &incoming[used], sizeof(header));
+        if (header.magic != STREAM_FRAME_MAGIC || header.payloadBytes > MAX_FRAME_BYTES) {
+            std::cerr << "ERROR::STREAM::BAD_FRAME: not a rain stream" << std::endl;
+            return false;
+        }
+        if (incoming.size() - used - sizeof(header) < header.payloadBytes) break;
+
+        // Every frame is a delta on the one before, so each is decoded even
+        // though the renderer only ever sees the newest
+        if (!decoder.decode(header, &incoming[used + sizeof(header)], snapshots.writeBuffer())) {
+            std::cerr << "ERROR::STREAM::BAD_FRAME: step " << header.step << std::endl;
+            return false;
+        }
+        snapshots.publish();
+        used += sizeof(header) + header.payloadBytes;
+    }
+    incoming.erase(incoming.begin(), incoming.begin() + used);
+    return true;
+}
@@ -0,0 +1,56 @@
+#ifndef STREAM_CLIENT_H
+#define STREAM_CLIENT_H
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FrameCodec.h"
+#include "SimulationThread.h"
+#include "TripleBuffer.h"
+
+// Viewer side of StreamServer.h: receives frames on its own thread and
+// publishes each as a RenderSnapshot, so the renderer reads it exactly as it
+// reads a local SimulationThread. The camera goes the other way so the
+// server can cull for it.
+class StreamClient {
+public:
+    StreamClient();
+    ~StreamClient();
+
+    // Connect without starting; false if the server can't be reached
+    bool connect(const std::string& address);
+    void start();
+    void stop();
+
+    // Render thread: swap in the latest frame if there is one
+    bool acquire() { return snapshots.acquire(); }
+    const RenderSnapshot& snapshot() const { return snapshots.readBuffer(); }
+
+    // Render thread: sent on the next pass of the network thread
+    void setCamera(const glm::vec3& position, const glm::vec3& front);
+
+    // False once the server has gone; the last frame stays readable
+    bool connected() const { return live.load(); }
+
+private:
+    void run();
+    bool receive();
+
+    int fd;
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<bool> live;
+    TripleBuffer<RenderSnapshot> snapshots;
+    FrameDecoder decoder;
+    std::vector<uint8_t> incoming;
+    std::vector<uint8_t> outgoing;
+
+    std::mutex cameraMutex;
+    StreamCamera pendingCamera;
+    std::atomic<bool> cameraChanged;
+};
+
+#endif
@@ -0,0 +1,287 @@
+#include "StreamServer.h"
+#include "FrameCodec.h"
+#include "SimulationThread.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0; // SIGPIPE is ignored instead
+#endif
+
+// Kernel send buffer per viewer. Frames only queue up in here, so it bounds
+// how far behind a slow viewer can fall before it starts missing frames
+const int SEND_BUFFER_BYTES = 128 * 1024;
+
+struct StreamAddress {
+    sockaddr_storage storage;
+    socklen_t length;
+    bool isUnix;
+    std::string path;
+};
+
+// A path if there's a '/', otherwise [host]:port with IPv4 hosts only
+static bool parseAddress(const std::string& address, StreamAddress& out) {
+    std::memset(&out.storage, 0, sizeof(out.storage));
+    out.isUnix = address.find('/') != std::string::npos;
+
+    if (out.isUnix) {
+        sockaddr_un* unixAddress = reinterpret_cast<sockaddr_un*>(&out.storage);
+        if (address.size() >= sizeof(unixAddress->sun_path)) {
+            std::cerr << "ERROR::STREAM::PATH_TOO_LONG: " << address << std::endl;
+            return false;
+        }
+        unixAddress->sun_family = AF_UNIX;
+        std::strcpy(unixAddress->sun_path, address.c_str());
+        out.length = sizeof(sockaddr_un);
+        out.path = address;
+        return true;
+    }
+
+    size_t colon = address.rfind(':');
+    std::string host = colon == std::string::npos ? "" : address.substr(0, colon);
+    int port = std::atoi(address.c_str() + (colon == std::string::npos ? 0 : colon + 1));
+    if (host.empty() || host == "localhost") host = "127.0.0.1";
+
+    sockaddr_in* inetAddress = reinterpret_cast<sockaddr_in*>(&out.storage);
+    inetAddress->sin_family = AF_INET;
+    inetAddress->sin_port = htons(static_cast<uint16_t>(port));
+    if (port <= 0 || port > 65535 || inet_pton(AF_INET, host.c_str(), &inetAddress->sin_addr) != 1) {
+        std::cerr << "ERROR::STREAM::BAD_ADDRESS: " << address << " (expected host:port or a socket path)" << std::endl;
+        return false;
+    }
+    out.length = sizeof(sockaddr_in);
+    return true;
+}
+
+static void configureSocket(int fd, bool isUnix) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    if (!isUnix) {
+        int noDelay = 1; // Frames should go out as soon as they're encoded
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    }
+}
+
+int connectStream(const std::string& address) {
+    StreamAddress target;
+    if (!parseAddress(address, target)) return -1;
+
+    int fd = socket(target.storage.ss_family, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&target.storage), target.length) < 0) {
+        std::cerr << "ERROR::STREAM::CONNECT_FAILED: " << address << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    configureSocket(fd, target.isUnix);
+    return fd;
+}
+
+struct StreamViewer {
+    int fd;
+    int id;
+    FrameEncoder encoder;
+    std::vector<uint8_t> outgoing; // Current frame
+    size_t sent;                   // Bytes of it already handed to the kernel
+    std::vector<uint8_t> incoming; // Partial camera messages
+    bool closed;
+
+    // Since the last report
+    unsigned framesSent, framesDropped;
+    size_t bytesSent, itemsSent;
+
+    StreamViewer(int fd, int id)
+        : fd(fd), id(id), sent(0), closed(false), framesSent(0), framesDropped(0), bytesSent(0), itemsSent(0) {}
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int) {
+    stopRequested = 1;
+}
+
+// Take every whole camera message the viewer has sent; the newest wins
+static void readCameras(StreamViewer& viewer) {
+    unsigned char chunk[4096];
+    for (;;) {
+        ssize_t received = recv(viewer.fd, chunk, sizeof(chunk), 0);
+        if (received > 0) {
+            viewer.incoming.insert(viewer.incoming.end(), chunk, chunk + received);
+            continue;
+        }
+        if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            viewer.closed = true;
+        }
+        break;
+    }
+
+    size_t used = 0;
+    while (viewer.incoming.size() - used >= sizeof(StreamCamera)) {
+        StreamCamera camera;
+        std::memcpy(&camera, &viewer.incoming[used], sizeof(camera));
+        used += sizeof(camera);
+        if (camera.magic != STREAM_CAMERA_MAGIC) {
+            std::cerr << "ERROR::STREAM::BAD_MESSAGE: viewer " << viewer.id << std::endl;
+            viewer.closed = true;
+            return;
+        }
+        viewer.encoder.setCamera(glm::vec3(camera.position[0], camera.position[1], camera.position[2]),
+                                 glm::vec3(camera.front[0], camera.front[1], camera.front[2]));
+    }
+    viewer.incoming.erase(viewer.incoming.begin(), viewer.incoming.begin() + used);
+}
+
+static void flush(StreamViewer& viewer) {
+    while (viewer.sent < viewer.outgoing.size()) {
+        ssize_t sent = send(viewer.fd, &viewer.outgoing[viewer.sent], viewer.outgoing.size() - viewer.sent, SEND_FLAGS);
+        if (sent > 0) {
+            viewer.sent += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            viewer.closed = true;
+        }
+        return;
+    }
+}
+
+int runStreamServer(Simulation& sim, const StreamConfig& config) {
+    StreamAddress address;
+    if (!parseAddress(config.address, address)) return 1;
+    if (address.isUnix) unlink(address.path.c_str()); // A stale socket from an earlier run
+
+    int listener = socket(address.storage.ss_family, SOCK_STREAM, 0);
+    int reuse = 1;
+    if (listener >= 0) setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (listener < 0 ||
+        bind(listener, reinterpret_cast<sockaddr*>(&address.storage), address.length) < 0 ||
+        listen(listener, 8) < 0) {
+        std::cerr << "ERROR::STREAM::LISTEN_FAILED: " << config.address << ": " << std::strerror(errno) << std::endl;
+        if (listener >= 0) close(listener);
+        return 1;
+    }
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+
+    // Streamed particles have to be real ones
+    sim.gpuSplashes = false;
+    SimulationThread simThread(sim, config.timestep);
+    simThread.start();
+    std::cout << "serving on " << config.address << std::endl;
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point lastReport = Clock::now();
+    std::vector<StreamViewer*> viewers;
+    std::vector<pollfd> fds;
+    int nextId = 1;
+    int pollMs = std::max(1, static_cast<int>(config.timestep * 500.0f)); // Half a step
+
+    while (!stopRequested) {
+        fds.clear();
+        pollfd listening = { listener, POLLIN, 0 };
+        fds.push_back(listening);
+        for (StreamViewer* viewer : viewers) {
+            short events = POLLIN;
+            if (viewer->sent < viewer->outgoing.size()) events |= POLLOUT;
+            pollfd entry = { viewer->fd, events, 0 };
+            fds.push_back(entry);
+        }
+        if (poll(fds.data(), fds.size(), pollMs) < 0 && errno != EINTR) {
+            std::cerr << "ERROR::STREAM::POLL_FAILED: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        size_t polled = viewers.size(); // Ones accepted below have no pollfd yet
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept(listener, NULL, NULL)) >= 0) {
+                if (viewers.size() >= config.maxViewers) {
+                    std::cerr << "WARNING::STREAM::TOO_MANY_VIEWERS: turned one away" << std::endl;
+                    close(fd);
+                    continue;
+                }
+                configureSocket(fd, address.isUnix);
+                setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &SEND_BUFFER_BYTES, sizeof(SEND_BUFFER_BYTES));
+                viewers.push_back(new StreamViewer(fd, nextId++));
+                std::cout << "viewer " << viewers.back()->id << " joined (" << viewers.size() << " watching)" << std::endl;
+            }
+        }
+
+        for (size_t i = 0; i < polled; i++) {
+            if (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) readCameras(*viewers[i]);
+        }
+
+        // One frame in flight per viewer: anyone still sending the last one misses this one
+        if (simThread.acquire()) {
+            const RenderSnapshot& snapshot = simThread.snapshot();
+            for (StreamViewer* viewer : viewers) {
+                if (viewer->closed) continue;
+                if (viewer->sent < viewer->outgoing.size()) {
+                    viewer->framesDropped++;
+                    continue;
+                }
+                viewer->outgoing.clear();
+                viewer->sent = 0;
+                viewer->encoder.encode(snapshot, viewer->outgoing);
+                viewer->framesSent++;
+                viewer->bytesSent += viewer->outgoing.size();
+                viewer->itemsSent += viewer->encoder.lastItemCount();
+            }
+        }
+
+        for (StreamViewer* viewer : viewers) {
+            if (!viewer->closed) flush(*viewer);
+        }
+
+        for (size_t i = 0; i < viewers.size();) {
+            if (!viewers[i]->closed) {
+                i++;
+                continue;
+            }
+            std::cout << "viewer " << viewers[i]->id << " left (" << viewers.size() - 1 << " watching)" << std::endl;
+            close(viewers[i]->fd);
+            delete viewers[i];
+            viewers.erase(viewers.begin() + i);
+        }
+
+        Clock::time_point now = Clock::now();
+        if (now - lastReport >= std::chrono::seconds(config.reportSeconds)) {
+            lastReport = now;
+            std::cout << "step " << simThread.snapshot().step << ", " << viewers.size() << " viewers, step "
+                      << simThread.stepMilliseconds() << " ms" << std::endl;
+            for (StreamViewer* viewer : viewers) {
+                double perItem = viewer->itemsSent ? static_cast<double>(viewer->bytesSent) / viewer->itemsSent : 0.0;
+                std::cout << "  viewer " << viewer->id << ": " << viewer->framesSent << " frames sent, "
+                          << viewer->framesDropped << " dropped, " << perItem << " bytes per item (16 raw)" << std::endl;
+                viewer->framesSent = viewer->framesDropped = 0;
+                viewer->bytesSent = viewer->itemsSent = 0;
+            }
+        }
+    }
+
+    simThread.stop();
+    for (StreamViewer* viewer : viewers) {
+        close(viewer->fd);
+        delete viewer;
+    }
+    close(listener);
+    if (address.isUnix) unlink(address.path.c_str());
+    return 0;
+}
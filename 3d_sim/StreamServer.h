@@ -0,0 +1,35 @@
+#ifndef STREAM_SERVER_H
+#define STREAM_SERVER_H
+
+#include <cstddef>
+#include <string>
+#include "Simulation.h"
+
+// Headless mode that runs the simulation and streams it to any number of
+// viewers (3d_simulation --connect) over TCP or a Unix socket. Viewers
+// attach and detach whenever they like.
+//
+// The simulation steps on its own SimulationThread exactly as it does under
+// the window; this thread takes each published snapshot and sends every
+// viewer a frame culled to its camera and delta-compressed against the last
+// frame that viewer got (see FrameCodec.h). A viewer gets a new frame only
+// once its previous one has left the process, so a slow viewer misses
+// frames instead of holding up the simulation or the other viewers.
+struct StreamConfig {
+    std::string address;  // "host:port", ":port" (127.0.0.1) or a Unix socket path
+    float timestep;       // Fixed seconds per step
+    int reportSeconds;    // Seconds between stats lines
+    size_t maxViewers;
+
+    StreamConfig()
+        : address("127.0.0.1:7878"), timestep(1.0f / 60.0f), reportSeconds(10), maxViewers(16) {}
+};
+
+// Serve until SIGINT/SIGTERM. Returns the process exit code.
+int runStreamServer(Simulation& sim, const StreamConfig& config);
+
+// Connect to a server at address (same forms as StreamConfig::address);
+// returns the socket or -1
+int connectStream(const std::string& address);
+
+#endif
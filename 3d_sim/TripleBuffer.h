@@ -0,0 +1,44 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Lock-free single-writer/single-reader triple buffer.
+// The writer fills writeBuffer() and publish()es it; the reader calls
+// acquire() to swap in the newest published buffer and then reads
+// readBuffer() in place for as long as it likes. Neither side ever waits or
+// copies: a third "middle" buffer is swapped between them via one atomic.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle(1), writeIndex(0), readIndex(2) {}
+
+    T& writeBuffer() { return buffers[writeIndex]; }
+
+    // Hand the write buffer over and take the middle one to write next
+    void publish() {
+        unsigned previous = middle.exchange(writeIndex | FRESH, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // Swap in the newest published buffer; false if nothing new since last time
+    bool acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        unsigned previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const { return buffers[readIndex]; }
+
+private:
+    static const unsigned INDEX_MASK = 3;
+    static const unsigned FRESH = 4; // Set while middle holds an unread buffer
+
+    T buffers[3];
+    std::atomic<unsigned> middle;
+    alignas(64) unsigned writeIndex; // Writer-only, kept off the reader's cache line
+    alignas(64) unsigned readIndex;  // Reader-only
+};
+
+#endif
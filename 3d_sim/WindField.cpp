@@ -0,0 +1,195 @@
+#include "WindField.h"
+#include <fstream>
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+WindField::WindField(glm::vec3 origin, glm::vec3 extent, int nx, int ny, int nz)
+    : prevailing(1.5f, 0.0f, 0.5f), gustStrength(2.0f), origin(origin), extent(extent),
+      nx(0), ny(0), nz(0), bricksX(0), bricksY(0) {
+    resize(nx, ny, nz);
+}
+
+void WindField::resize(int newX, int newY, int newZ) {
+    // Round node counts up to whole bricks so every brick is full
+    nx = std::max(2, (newX + BRICK - 1) / BRICK * BRICK);
+    ny = std::max(2, (newY + BRICK - 1) / BRICK * BRICK);
+    nz = std::max(2, (newZ + BRICK - 1) / BRICK * BRICK);
+    bricksX = (nx + BRICK - 1) / BRICK;
+    bricksY = (ny + BRICK - 1) / BRICK;
+    int bricksZ = (nz + BRICK - 1) / BRICK;
+
+    // Spacing follows the requested counts; any padding nodes sit past the extent
+    invSpacing = glm::vec3((std::max(2, newX) - 1) / extent.x,
+                           (std::max(2, newY) - 1) / extent.y,
+                           (std::max(2, newZ) - 1) / extent.z);
+
+    const size_t brickSize = BRICK * BRICK * BRICK;
+    offsetX.resize(nx);
+    offsetY.resize(ny);
+    offsetZ.resize(nz);
+    for (int i = 0; i < nx; i++)
+        offsetX[i] = (i / BRICK) * brickSize + (i % BRICK);
+    for (int j = 0; j < ny; j++)
+        offsetY[j] = (j / BRICK) * bricksX * brickSize + (j % BRICK) * BRICK;
+    for (int k = 0; k < nz; k++)
+        offsetZ[k] = (k / BRICK) * bricksX * bricksY * brickSize + (k % BRICK) * BRICK * BRICK;
+
+    stepX.assign(nx, 0);
+    stepY.assign(ny, 0);
+    stepZ.assign(nz, 0);
+    for (int i = 0; i + 1 < nx; i++) stepX[i] = offsetX[i + 1] - offsetX[i];
+    for (int j = 0; j + 1 < ny; j++) stepY[j] = offsetY[j + 1] - offsetY[j];
+    for (int k = 0; k + 1 < nz; k++) stepZ[k] = offsetZ[k + 1] - offsetZ[k];
+
+    size_t total = static_cast<size_t>(bricksX) * bricksY * bricksZ * BRICK * BRICK * BRICK;
+    base.assign(total * 4, 0.0f);
+    field.assign(total * 4, 0.0f);
+
+    // Wind picks up with height above the ground (rough log profile)
+    heightProfile.resize(ny);
+    for (int j = 0; j < ny; j++) {
+        float height = j / invSpacing.y;
+        heightProfile[j] = std::log(1.0f + height * 2.0f) / std::log(1.0f + extent.y * 2.0f);
+    }
+}
+
+bool WindField::loadFromFile(const char* filePath) {
+    std::ifstream windFile(filePath);
+    if (!windFile.is_open()) {
+        std::cerr << "ERROR::WIND::FILE_NOT_FOUND: " << filePath << std::endl;
+        return false;
+    }
+
+    int fileX, fileY, fileZ;
+    if (!(windFile >> fileX >> fileY >> fileZ) || fileX < 2 || fileY < 2 || fileZ < 2) {
+        std::cerr << "ERROR::WIND::BAD_HEADER: " << filePath << std::endl;
+        return false;
+    }
+
+    std::vector<glm::vec3> values(static_cast<size_t>(fileX) * fileY * fileZ);
+    for (size_t n = 0; n < values.size(); n++) {
+        if (!(windFile >> values[n].x >> values[n].y >> values[n].z)) {
+            std::cerr << "ERROR::WIND::TRUNCATED: " << filePath << std::endl;
+            return false;
+        }
+    }
+
+    // The file grid may not be a whole number of bricks; pad by repeating the edge
+    resize(fileX, fileY, fileZ);
+    for (int k = 0; k < nz; k++) {
+        for (int j = 0; j < ny; j++) {
+            for (int i = 0; i < nx; i++) {
+                int fi = std::min(i, fileX - 1), fj = std::min(j, fileY - 1), fk = std::min(k, fileZ - 1);
+                const glm::vec3& value = values[fi + fileX * (fj + fileY * fk)];
+                float* node = &base[index(i, j, k) * 4];
+                node[0] = value.x;
+                node[1] = value.y;
+                node[2] = value.z;
+            }
+        }
+    }
+    return true;
+}
+
+void WindField::update(float time) {
+    // Gusts are travelling waves that are separable in x and z, so the trig
+    // is done once per row/column instead of once per node
+    gustX.resize(nx);
+    gustZ.resize(nz);
+    for (int i = 0; i < nx; i++) {
+        float x = origin.x + i / invSpacing.x;
+        gustX[i] = std::sin(0.6f * x - 1.3f * time) * 0.5f + 0.5f;
+    }
+    for (int k = 0; k < nz; k++) {
+        float z = origin.z + k / invSpacing.z;
+        gustZ[k] = std::cos(0.4f * z - 0.7f * time + 1.0f) * 0.5f + 0.5f;
+    }
+    float swirl = std::sin(0.25f * time);
+
+    for (int k = 0; k < nz; k++) {
+        for (int j = 0; j < ny; j++) {
+            float h = heightProfile[j];
+            for (int i = 0; i < nx; i++) {
+                float gust = gustStrength * gustX[i] * gustZ[k];
+                size_t idx = index(i, j, k) * 4;
+                field[idx + 0] = base[idx + 0] + (prevailing.x + gust) * h;
+                field[idx + 1] = base[idx + 1] + prevailing.y + gust * 0.1f * swirl;
+                field[idx + 2] = base[idx + 2] + (prevailing.z + gust * swirl * 0.5f) * h;
+            }
+        }
+    }
+}
+
+glm::vec3 WindField::sample(const glm::vec3& p) const {
+    glm::vec3 result;
+    sampleBatch(&p.x, &p.y, &p.z, &result.x, &result.y, &result.z, 1);
+    return result;
+}
+
+void WindField::sampleBatch(const float* px, const float* py, const float* pz,
+                            float* wx, float* wy, float* wz, size_t count) const {
+    // Pass 1 works on plain float arrays so the compiler can vectorize it:
+    // grid coordinates, base cell and fractional weights for each position.
+    // Pass 2 gathers the 8 corners per position and blends them.
+    int ci[BATCH], cj[BATCH], ck[BATCH];
+    float tx[BATCH], ty[BATCH], tz[BATCH];
+    float maxX = nx - 1.001f, maxY = ny - 1.001f, maxZ = nz - 1.001f;
+
+    for (size_t start = 0; start < count; start += BATCH) {
+        size_t n = std::min(count - start, static_cast<size_t>(BATCH));
+        const float* __restrict x = px + start;
+        const float* __restrict y = py + start;
+        const float* __restrict z = pz + start;
+
+        // 0 goes first in std::max so a NaN position clamps to the grid
+        // instead of turning into an out-of-range index
+        for (size_t i = 0; i < n; i++) {
+            float gx = std::min(std::max(0.0f, (x[i] - origin.x) * invSpacing.x), maxX);
+            float gy = std::min(std::max(0.0f, (y[i] - origin.y) * invSpacing.y), maxY);
+            float gz = std::min(std::max(0.0f, (z[i] - origin.z) * invSpacing.z), maxZ);
+            ci[i] = static_cast<int>(gx);
+            cj[i] = static_cast<int>(gy);
+            ck[i] = static_cast<int>(gz);
+            tx[i] = gx - ci[i];
+            ty[i] = gy - cj[i];
+            tz[i] = gz - ck[i];
+        }
+
+        float* __restrict outX = wx + start;
+        float* __restrict outY = wy + start;
+        float* __restrict outZ = wz + start;
+        const float* nodes = field.data();
+        for (size_t i = 0; i < n; i++) {
+            // Neighbours are one step away along each axis from the base corner
+            size_t sx = stepX[ci[i]] * 4, sy = stepY[cj[i]] * 4, sz = stepZ[ck[i]] * 4;
+            const float* c000 = nodes + index(ci[i], cj[i], ck[i]) * 4;
+            const float* c100 = c000 + sx;
+            const float* c010 = c000 + sy;
+            const float* c110 = c000 + sx + sy;
+            const float* c001 = c000 + sz;
+            const float* c101 = c001 + sx;
+            const float* c011 = c001 + sy;
+            const float* c111 = c001 + sx + sy;
+
+            float ax = 1.0f - tx[i], ay = 1.0f - ty[i], az = 1.0f - tz[i];
+            float w000 = ax * ay * az;
+            float w100 = tx[i] * ay * az;
+            float w010 = ax * ty[i] * az;
+            float w110 = tx[i] * ty[i] * az;
+            float w001 = ax * ay * tz[i];
+            float w101 = tx[i] * ay * tz[i];
+            float w011 = ax * ty[i] * tz[i];
+            float w111 = tx[i] * ty[i] * tz[i];
+
+            float result[3];
+            for (int c = 0; c < 3; c++) {
+                result[c] = c000[c] * w000 + c100[c] * w100 + c010[c] * w010 + c110[c] * w110
+                          + c001[c] * w001 + c101[c] * w101 + c011[c] * w011 + c111[c] * w111;
+            }
+            outX[i] = result[0];
+            outY[i] = result[1];
+            outZ[i] = result[2];
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef WIND_FIELD_H
+#define WIND_FIELD_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+// Time-varying 3D wind sampled on a regular grid of nodes.
+// Nodes are stored in 4x4x4 bricks (one brick = 64 nodes = 1 KB) so droplets
+// falling through a column keep touching the same few cache lines instead of
+// striding through whole grid slices. Each node keeps u, v, w and a pad float
+// together, so one trilinear corner is a single 16-byte load.
+class WindField {
+public:
+    static const int BRICK = 4;
+    static const int BATCH = 64; // Positions sampled per SoA batch
+
+    WindField(glm::vec3 origin, glm::vec3 extent, int nx, int ny, int nz);
+
+    // Load a static base field from a text file:
+    //   first line "nx ny nz", then nx*ny*nz lines of "u v w" (x fastest).
+    // Keeps the current grid and returns false if the file can't be read.
+    bool loadFromFile(const char* filePath);
+
+    // Rebuild the field for the given simulation time (base field + gusts)
+    void update(float time);
+
+    glm::vec3 sample(const glm::vec3& p) const;
+
+    // Slide the grid sideways so it starts at (x, z). Gusts are a function of
+    // world position, so they carry on seamlessly from the next update(); a
+    // loaded base field moves along with the grid.
+    void moveOrigin(float x, float z) { origin.x = x; origin.z = z; }
+    glm::vec3 spacing() const { return 1.0f / invSpacing; }
+
+    // Sample wind for count positions given as separate x/y/z arrays
+    void sampleBatch(const float* px, const float* py, const float* pz,
+                     float* wx, float* wy, float* wz, size_t count) const;
+
+    glm::vec3 prevailing;  // Mean wind added everywhere (m/s)
+    float gustStrength;    // Peak gust speed on top of the prevailing wind
+
+private:
+    glm::vec3 origin;
+    glm::vec3 extent;
+    glm::vec3 invSpacing;
+    int nx, ny, nz;          // Node counts
+    int bricksX, bricksY;    // Bricks along x and y (z is implied)
+
+    std::vector<float> base;  // Loaded field (zero if procedural), 4 floats per node
+    std::vector<float> field; // Current field, brick-major, 4 floats per node
+
+    std::vector<float> heightProfile; // Wind speed-up with height, per y node
+    std::vector<float> gustX, gustZ;  // Scratch for update(), kept to avoid allocating every step
+
+    // Per-axis node offsets into the brick layout; index(i,j,k) is their sum.
+    // stepX[i] is the offset from node i to node i+1 (it jumps at brick edges).
+    std::vector<size_t> offsetX, offsetY, offsetZ;
+    std::vector<size_t> stepX, stepY, stepZ;
+
+    void resize(int nx, int ny, int nz);
+
+    size_t index(int i, int j, int k) const {
+        return offsetX[i] + offsetY[j] + offsetZ[k];
+    }
+};
+
+// Store the local wind in each item's wind member, which drag then works
+// against. Works on anything with position/wind members, e.g. Droplet or
+// Particle. Positions are gathered into small SoA batches so the grid lookups
+// run over contiguous arrays rather than one vec3 at a time.
+//
+// With stride > 1 only one contiguous slice of the items (chosen by step) is
+// refreshed and the rest keep last step's value. Wind changes slowly compared
+// to the timestep, so this spreads the sampling cost of large particle counts
+// over several frames.
+template <typename T>
+void sampleWind(const WindField& wind, std::vector<T>& items, int stride = 1, unsigned step = 0) {
+    float px[WindField::BATCH], py[WindField::BATCH], pz[WindField::BATCH];
+    float wx[WindField::BATCH], wy[WindField::BATCH], wz[WindField::BATCH];
+
+    size_t slice = step % stride;
+    size_t begin = items.size() * slice / stride;
+    size_t end = items.size() * (slice + 1) / stride;
+
+    for (size_t start = begin; start < end; start += WindField::BATCH) {
+        size_t n = std::min(end - start, static_cast<size_t>(WindField::BATCH));
+
+        for (size_t i = 0; i < n; i++) {
+            const glm::vec3& p = items[start + i].position;
+            px[i] = p.x;
+            py[i] = p.y;
+            pz[i] = p.z;
+        }
+
+        wind.sampleBatch(px, py, pz, wx, wy, wz, n);
+
+        for (size_t i = 0; i < n; i++) {
+            items[start + i].wind = glm::vec3(wx[i], wy[i], wz[i]);
+        }
+    }
+}
+
+#endif
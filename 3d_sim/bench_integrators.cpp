@@ -0,0 +1,89 @@
+// Accuracy vs cost of each integrator policy against an analytic fall.
+//
+// A drop released from rest in still air with quadratic drag has
+//   v(t) = -Vt tanh(g t / Vt)
+//   y(t) = -(Vt^2 / g) ln cosh(g t / Vt)
+// so each integrator is run over a range of timesteps and compared to that.
+//
+// Build and run with: make bench && ./bench_integrators
+
+#include "Integrators.h"
+#include "Drag.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+const float GRAVITY = 9.8f;
+const float FALL_TIME = 2.0f; // Seconds simulated for the accuracy check
+const int COST_PARTICLES = 1000000;
+const int COST_STEPS = 20;
+
+struct Result {
+    float maxPositionError;
+    float finalVelocityError;
+    double nsPerStep;
+};
+
+template <typename Integrator>
+Result measure(float size, float dt) {
+    Result result;
+    AirForces forces(glm::vec3(0.0f), dragCoefficient(size));
+    float vt = std::sqrt(GRAVITY / forces.dragK); // Exact for the tabulated k
+
+    // Accuracy: one drop against the closed form
+    glm::vec3 position(0.0f), velocity(0.0f);
+    int steps = static_cast<int>(FALL_TIME / dt + 0.5f);
+    result.maxPositionError = 0.0f;
+    for (int i = 1; i <= steps; i++) {
+        Integrator::step(position, velocity, forces, dt);
+        float t = i * dt;
+        float y = -(vt * vt / GRAVITY) * std::log(std::cosh(GRAVITY * t / vt));
+        result.maxPositionError = std::max(result.maxPositionError, std::abs(position.y - y));
+    }
+    float v = -vt * std::tanh(GRAVITY * steps * dt / vt);
+    result.finalVelocityError = std::abs(velocity.y - v);
+
+    // Cost: a large batch stepped the way the simulation steps particles
+    std::vector<glm::vec3> positions(COST_PARTICLES, glm::vec3(0.0f, 5.0f, 0.0f));
+    std::vector<glm::vec3> velocities(COST_PARTICLES, glm::vec3(0.1f, 0.0f, 0.0f));
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < COST_STEPS; s++) {
+        for (int i = 0; i < COST_PARTICLES; i++) {
+            Integrator::step(positions[i], velocities[i], forces, dt);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    result.nsPerStep = ns / (static_cast<double>(COST_PARTICLES) * COST_STEPS);
+
+    // Keep the batch from being optimised away
+    if (positions[COST_PARTICLES / 2].y == 12345.0f) std::printf(" ");
+    return result;
+}
+
+template <typename Integrator>
+void report(const char* label, float size) {
+    const float timesteps[] = { 0.001f, 0.005f, 0.0166f, 0.033f };
+    for (float dt : timesteps) {
+        Result r = measure<Integrator>(size, dt);
+        std::printf("%-7s %-20s dt=%.4f  max|dy|=%.6f m  |dv(T)|=%.6f m/s  %.2f ns/step\n",
+                    label, Integrator::name(), dt, r.maxPositionError, r.finalVelocityError, r.nsPerStep);
+    }
+}
+
+int main() {
+    // A spawned rain drop (2 mm) and a small splash particle (0.13 mm)
+    const float sizes[] = { 0.3f, 0.02f };
+    const char* labels[] = { "rain", "splash" };
+
+    for (int i = 0; i < 2; i++) {
+        std::printf("%s drop: size %.2f, terminal velocity %.3f m/s\n",
+                    labels[i], sizes[i], terminalVelocity(sizes[i]));
+        report<ExplicitEuler>(labels[i], sizes[i]);
+        report<SemiImplicitEuler>(labels[i], sizes[i]);
+        report<VelocityVerlet>(labels[i], sizes[i]);
+        std::printf("\n");
+    }
+    return 0;
+}
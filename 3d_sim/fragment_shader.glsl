@@ -3,12 +3,36 @@ out vec4 FragColor;
 
 in vec3 FragPos;
 in vec3 Normal;
+in float ParticleAlpha;
 
 uniform vec3 lightPos;
 uniform vec3 viewPos;
 uniform vec3 groundColor;
 uniform vec3 dropletColor;
 uniform float objectAlpha = 1.0; // Default to fully opaque if not specified
+uniform bool puddle = false; // Flat water lying on the ground
+
+// Rain shadows from the main light (see ShadowMap.h); off unless a map is bound
+uniform mat4 lightSpace;
+uniform sampler2DShadow shadowMap;
+uniform float shadowStrength = 0.0;
+
+// How much of the light the drops block here, 0..1. Each of the 3x3 taps is
+// itself a 2x2 hardware comparison, so edges come out soft
+float rainShadow()
+{
+    vec4 lightClip = lightSpace * vec4(FragPos, 1.0);
+    vec3 coords = lightClip.xyz / lightClip.w * 0.5 + 0.5;
+    if (coords.z > 1.0) return 0.0;
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0));
+    float lit = 0.0;
+    for (int x = -1; x <= 1; x++) {
+        for (int y = -1; y <= 1; y++) {
+            lit += texture(shadowMap, vec3(coords.xy + vec2(x, y) * texel, coords.z - 0.001));
+        }
+    }
+    return 1.0 - lit / 9.0;
+}
 
 void main()
 {
@@ -45,7 +69,9 @@ void main()
     
     // Use a more reliable way to detect if we're rendering the ground
     // Ground plane is at y = -2.0 as defined in your code
-    if (abs(FragPos.y + 2.0) < 0.1) { // Ground plane with some tolerance
+    // Puddles lie within that tolerance too, so they are flagged instead
+    bool ground = !puddle && abs(FragPos.y + 2.0) < 0.1; // Ground plane with some tolerance
+    if (ground) {
         result = groundColor;
         finalAlpha = 1.0; // Ground is opaque
     } else {
@@ -62,6 +88,11 @@ void main()
         finalAlpha = alpha;
     }
 
+    // Ground and the puddles lying on it catch the rain's shadow
+    if (shadowStrength > 0.0 && (ground || puddle)) {
+        result *= 1.0 - shadowStrength * rainShadow();
+    }
+
     // Apply the object's alpha value (for particles)
-    FragColor = vec4(result, finalAlpha * objectAlpha);
+    FragColor = vec4(result, finalAlpha * objectAlpha * ParticleAlpha);
 }
\ No newline at end of file
@@ -0,0 +1,214 @@
+// Python bindings for the simulation core (pybind11).
+//
+// Build with: make python   (needs pybind11 and the Python headers)
+//
+//     import rain
+//     world = rain.World(seed=1)
+//     world.step(1 / 60, steps=600)
+//     p = world.particle_arrays()
+//     p["position"]   # (n, 3) float32, n = number of live splash particles
+//
+// The arrays are views straight into the simulation's vectors: no copying,
+// and writes go through to the simulation. A step(), reset() or recentre()
+// can grow, shrink or reallocate those vectors, which would leave a view
+// pointing at freed memory, so while any view (or any array sliced from
+// one) is alive they raise BufferError instead, the way bytearray refuses
+// to resize while exported. Drop the views before stepping and take fresh
+// ones after:
+//
+//     del p
+//     world.step()
+//
+// np.array() makes a copy that can be kept across steps. Drops and
+// particles are stored as structs, so each field is a strided view (row
+// stride = the struct size), which NumPy handles like any other array;
+// np.ascontiguousarray() makes a packed copy if needed.
+//
+// Everything runs with the GIL held, step() included, so no other Python
+// thread can read a view while the simulation moves.
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include "Simulation.h"
+
+namespace py = pybind11;
+
+// Zero-length views still need somewhere to point
+static float emptyStorage[4];
+
+// Live sets of views per World (only touched with the GIL held)
+static std::unordered_map<const Simulation*, int> liveViews;
+
+// Base of every array from one droplet_arrays()/particle_arrays() call, and
+// so of every array NumPy slices from those. It keeps the World alive, and
+// while it lives the World's vectors must stay where they are
+struct ViewGuard {
+    explicit ViewGuard(py::object world) : world(world), sim(&world.cast<Simulation&>()) { liveViews[sim]++; }
+    ~ViewGuard() {
+        if (--liveViews[sim] == 0) liveViews.erase(sim);
+    }
+    ViewGuard(const ViewGuard&) = delete;
+    ViewGuard& operator=(const ViewGuard&) = delete;
+
+    py::object world;
+    const Simulation* sim;
+};
+
+// Called before anything that can move the vectors under a view
+static void requireNoViews(const Simulation& sim, const char* action) {
+    auto found = liveViews.find(&sim);
+    if (found == liveViews.end()) return;
+    throw py::buffer_error("can't " + std::string(action) + " while " + std::to_string(found->second) +
+                           " set(s) of array views into this World are alive; del them first "
+                           "(np.array() makes a copy that can be kept)");
+}
+
+static py::object viewGuard(py::object world) {
+    return py::cast(new ViewGuard(world), py::return_value_policy::take_ownership);
+}
+
+// Strided (count, columns) float view of a field inside each T of a vector,
+// or (count,) when columns is 0
+template <typename T>
+static py::array fieldView(std::vector<T>& items, size_t offset, size_t columns, py::handle owner) {
+    float* data = items.empty() ? emptyStorage
+                                : reinterpret_cast<float*>(reinterpret_cast<char*>(items.data()) + offset);
+    std::vector<py::ssize_t> shape, strides;
+    shape.push_back(static_cast<py::ssize_t>(items.size()));
+    strides.push_back(static_cast<py::ssize_t>(sizeof(T)));
+    if (columns > 0) {
+        shape.push_back(static_cast<py::ssize_t>(columns));
+        strides.push_back(static_cast<py::ssize_t>(sizeof(float)));
+    }
+    return py::array(py::dtype::of<float>(), shape, strides, data, owner);
+}
+
+static std::vector<Droplet>& dropletBucket(Simulation& sim, const std::string& state) {
+    if (state == "falling") return sim.droplets;
+    if (state == "sliding") return sim.sliding;
+    if (state == "pooled") return sim.pooled;
+    throw py::value_error("state must be 'falling', 'sliding' or 'pooled', not '" + state + "'");
+}
+
+static py::dict dropletArrays(py::object self, const std::string& state) {
+    std::vector<Droplet>& drops = dropletBucket(self.cast<Simulation&>(), state);
+    py::object guard = viewGuard(self);
+    py::dict arrays;
+    arrays["position"] = fieldView(drops, offsetof(Droplet, position), 3, guard);
+    arrays["velocity"] = fieldView(drops, offsetof(Droplet, velocity), 3, guard);
+    arrays["size"] = fieldView(drops, offsetof(Droplet, size), 0, guard);
+    arrays["deform"] = fieldView(drops, offsetof(Droplet, deformFactor), 0, guard);
+    arrays["wind"] = fieldView(drops, offsetof(Droplet, wind), 3, guard);
+    arrays["state_time"] = fieldView(drops, offsetof(Droplet, stateTime), 0, guard);
+    return arrays;
+}
+
+static py::dict particleArrays(py::object self) {
+    Simulation& sim = self.cast<Simulation&>();
+    if (sim.compactParticles) {
+        throw py::value_error("compact particles are quantized and can't be viewed; "
+                              "use compact_particle_arrays() for a decoded copy");
+    }
+    std::vector<Particle>& particles = sim.particles;
+    py::object guard = viewGuard(self);
+    py::dict arrays;
+    arrays["position"] = fieldView(particles, offsetof(Particle, position), 3, guard);
+    arrays["velocity"] = fieldView(particles, offsetof(Particle, velocity), 3, guard);
+    arrays["size"] = fieldView(particles, offsetof(Particle, size), 0, guard);
+    arrays["life"] = fieldView(particles, offsetof(Particle, life), 0, guard);
+    arrays["max_life"] = fieldView(particles, offsetof(Particle, maxLife), 0, guard);
+    arrays["wind"] = fieldView(particles, offsetof(Particle, wind), 3, guard);
+    return arrays;
+}
+
+// The compact store has no floats to alias, so this one decodes into new arrays
+static py::dict compactParticleArrays(Simulation& sim) {
+    size_t count = sim.compact.size();
+    py::array_t<float> position({ count, static_cast<size_t>(3) });
+    py::array_t<float> velocity({ count, static_cast<size_t>(3) });
+    py::array_t<float> size(count);
+    py::array_t<float> alpha(count);
+    auto p = position.mutable_unchecked<2>();
+    auto v = velocity.mutable_unchecked<2>();
+    auto s = size.mutable_unchecked<1>();
+    auto a = alpha.mutable_unchecked<1>();
+    for (size_t i = 0; i < count; i++) {
+        glm::vec3 pi = sim.compact.position(i), vi = sim.compact.velocity(i);
+        for (int c = 0; c < 3; c++) {
+            p(i, c) = pi[c];
+            v(i, c) = vi[c];
+        }
+        s(i) = sim.compact.particleSize(i);
+        a(i) = sim.compact.alpha(i);
+    }
+    py::dict arrays;
+    arrays["position"] = position;
+    arrays["velocity"] = velocity;
+    arrays["size"] = size;
+    arrays["alpha"] = alpha;
+    return arrays;
+}
+
+static Simulation* makeWorld(std::pair<float, float> regionMin, std::pair<float, float> regionMax,
+                             py::object seed, bool compact) {
+    Simulation* sim = new Simulation(glm::vec2(regionMin.first, regionMin.second),
+                                     glm::vec2(regionMax.first, regionMax.second));
+    if (!seed.is_none()) sim->random.seed(seed.cast<uint32_t>());
+    sim->compactParticles = compact;
+    return sim;
+}
+
+PYBIND11_MODULE(rain, m) {
+    m.doc() = "Rain simulation core: drops, splashes and wind, stepped from Python";
+
+    py::class_<ViewGuard>(m, "_ArrayViews");
+
+    py::class_<Simulation>(m, "World")
+        .def(py::init(&makeWorld),
+             py::arg("region_min") = std::make_pair(-5.0f, -5.0f),
+             py::arg("region_max") = std::make_pair(5.0f, 5.0f),
+             py::arg("seed") = py::none(), py::arg("compact") = false,
+             "Rain over [region_min, region_max] on the ground plane (x, z). A seed makes the run repeatable.")
+        .def("step", [](Simulation& sim, float dt, int steps) {
+                 // Keeps the GIL: no other thread may read the vectors mid-step
+                 requireNoViews(sim, "step");
+                 for (int i = 0; i < steps; i++) sim.step(dt);
+             },
+             py::arg("dt") = 1.0f / 60.0f, py::arg("steps") = 1)
+        .def("reset", [](Simulation& sim) {
+                 requireNoViews(sim, "reset");
+                 sim.reset();
+             })
+        .def("seed", [](Simulation& sim, uint32_t value) { sim.random.seed(value); })
+        .def("recentre", [](Simulation& sim, float x, float z) {
+                 requireNoViews(sim, "recentre");
+                 sim.recentre(glm::vec2(x, z));
+             },
+             "Move the simulated region, keeping its size, to centre it near (x, z)")
+        .def("droplet_arrays", &dropletArrays, py::arg("state") = "falling",
+             "Views of the drops in one lifecycle state: 'falling', 'sliding' or 'pooled'")
+        .def("particle_arrays", &particleArrays, "Views of the splash particles")
+        .def("compact_particle_arrays", &compactParticleArrays, "Decoded copy of a compact world's particles")
+        .def("load_wind", [](Simulation& sim, const std::string& path) { return sim.wind.loadFromFile(path.c_str()); })
+        .def("sample_wind", [](const Simulation& sim, float x, float y, float z) {
+                 glm::vec3 w = sim.wind.sample(glm::vec3(x, y, z));
+                 return py::make_tuple(w.x, w.y, w.z);
+             })
+        .def_property_readonly("time", [](const Simulation& sim) { return sim.time; })
+        .def_property_readonly("step_count", [](const Simulation& sim) { return sim.stepCount; })
+        .def_property_readonly("particle_count", [](const Simulation& sim) {
+                 return sim.compactParticles ? sim.compact.size() : sim.particles.size();
+             })
+        .def_readwrite("spawn_interval", &Simulation::spawnInterval)
+        .def_readwrite("spawn_height", &Simulation::spawnHeight)
+        .def_readwrite("drop_size", &Simulation::dropSize)
+        .def_readwrite("ground_height", &Simulation::groundHeight)
+        .def_readwrite("pool_soak_time", &Simulation::poolSoakTime)
+        .def_readwrite("splash_scale", &Simulation::splashScale)
+        .def_readwrite("lifetime_scale", &Simulation::lifetimeScale)
+        .def_readwrite("spawn_scale", &Simulation::spawnScale);
+}
@@ -0,0 +1,8 @@
+#version 330 core
+// Depth only: cut the point sprite down to the drop's disc
+
+void main()
+{
+    vec2 fromCentre = gl_PointCoord * 2.0 - 1.0;
+    if (dot(fromCentre, fromCentre) > 1.0) discard;
+}
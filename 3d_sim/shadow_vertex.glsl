@@ -0,0 +1,13 @@
+#version 330 core
+// Rain shadow casters (ShadowMap): one point per drop or particle, sized to
+// cover its disc in the light's orthographic view
+layout (location = 0) in vec4 caster; // xyz + mesh scale
+
+uniform mat4 lightSpace;
+uniform float pixelsPerUnit; // Diameter in texels per unit of scale
+
+void main()
+{
+    gl_Position = lightSpace * vec4(caster.xyz, 1.0);
+    gl_PointSize = max(caster.w * pixelsPerUnit, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+
+out vec3 TexCoords;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    TexCoords = position;
+
+    // Drop the translation so the sky stays centred on the camera
+    vec4 clipPos = projection * mat4(mat3(view)) * vec4(position, 1.0);
+
+    // z = w puts the sky on the far plane (depth 1.0), so with GL_LEQUAL it
+    // only shades pixels nothing else has covered
+    gl_Position = clipPos.xyww;
+}
@@ -0,0 +1,46 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+
+// Per-instance birth state (SplashSpawn)
+layout (location = 2) in vec4 birthPosition; // xyz, w = birth time
+layout (location = 3) in vec4 birthVelocity; // xyz, w = lifespan
+layout (location = 4) in vec4 drift;         // xyz = velocity it relaxes to, w = relax time
+layout (location = 5) in float size;
+
+out vec3 FragPos;
+out vec3 Normal;
+out float ParticleAlpha;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float time;
+
+void main()
+{
+    float age = time - birthPosition.w;
+    float lifespan = birthVelocity.w;
+
+    // Not born yet or already expired: put it outside the clip volume
+    if (age < 0.0 || age >= lifespan) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        FragPos = vec3(0.0);
+        Normal = normal;
+        ParticleAlpha = 0.0;
+        return;
+    }
+
+    // Gravity plus linear drag: dv/dt = (drift - v) / tau, solved exactly
+    float tau = drift.w;
+    float decay = exp(-age / tau);
+    vec3 center = birthPosition.xyz + drift.xyz * age + (birthVelocity.xyz - drift.xyz) * tau * (1.0 - decay);
+
+    // Fade out and shrink a little as it ages
+    float remaining = 1.0 - age / lifespan;
+    ParticleAlpha = remaining * 0.9;
+    float scale = size * (0.8 + 0.2 * remaining);
+
+    FragPos = center + position * scale;
+    Normal = normal;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 330 core
+out vec4 FragColor;
+
+in float StreakAlpha;
+in float Across;
+in float Along;
+
+void main()
+{
+    // Soft edges, brightest at the leading end
+    float edge = 1.0 - abs(Across);
+    FragColor = vec4(0.75, 0.82, 0.9, StreakAlpha * edge * mix(0.3, 1.0, Along));
+}
@@ -0,0 +1,83 @@
+#version 330 core
+// Far-field rain streaks (RainStreaks). No vertex attributes: the streak
+// comes from hashing gl_InstanceID and the corner from gl_VertexID.
+
+out float StreakAlpha;
+out float Across; // -1..1 across the streak
+out float Along;  // 0 at the tail, 1 at the head
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraPos;
+uniform vec3 wind;
+uniform float time;
+uniform float groundHeight;
+uniform float ceiling;
+uniform float innerRadius;
+uniform float blendWidth;
+uniform float layerSize;
+uniform float opacity;
+uniform uint layerSeed;
+
+const vec2 CORNERS[6] = vec2[6](vec2(-1.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+                                vec2(-1.0, 0.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+uint hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float nextRandom(inout uint state)
+{
+    state = hash(state);
+    return float(state >> 8) * (1.0 / 16777216.0);
+}
+
+void main()
+{
+    uint state = hash(uint(gl_InstanceID) ^ (layerSeed * 0x9e3779b9u));
+    float rx = nextRandom(state);
+    float ry = nextRandom(state);
+    float rz = nextRandom(state);
+
+    // Drops of 1-3 mm fall at roughly 4-8 m/s
+    float speed = mix(4.0, 8.0, nextRandom(state));
+    vec3 velocity = vec3(wind.x, -speed, wind.z);
+
+    // Fall through the column and start again at the top
+    float height = ceiling - groundHeight;
+    float y = ceiling - mod(ry * height + speed * time, height);
+
+    // Fixed in world space (drifting with the wind), wrapped into the box around the camera
+    vec2 xz = vec2(rx, rz) * layerSize + wind.xz * time;
+    xz = cameraPos.xz + mod(xz - cameraPos.xz + 0.5 * layerSize, layerSize) - 0.5 * layerSize;
+    vec3 head = vec3(xz.x, y, xz.y);
+
+    // Fade in past the simulated rain and out towards the edge of the box
+    float horizontal = length(xz - cameraPos.xz);
+    StreakAlpha = opacity * smoothstep(innerRadius - blendWidth, innerRadius, horizontal)
+                          * (1.0 - smoothstep(0.35 * layerSize, 0.5 * layerSize, horizontal));
+    if (StreakAlpha <= 0.0) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        Across = Along = 0.0;
+        return;
+    }
+
+    // About 1/25 s of motion blur, a little wider with distance so far
+    // streaks don't shrink below a pixel and shimmer
+    vec3 tail = head - velocity * 0.04;
+    vec3 toCamera = cameraPos - head;
+    vec3 side = normalize(cross(head - tail, toCamera));
+    float width = max(0.004, length(toCamera) * 0.0015);
+
+    vec2 corner = CORNERS[gl_VertexID];
+    Across = corner.x;
+    Along = corner.y;
+    vec3 position = mix(tail, head, corner.y) + side * corner.x * width * 0.5;
+    gl_Position = projection * view * vec4(position, 1.0);
+}
@@ -4,6 +4,7 @@ layout (location = 1) in vec3 normal;
 
 out vec3 FragPos;
 out vec3 Normal;
+out float ParticleAlpha;
 
 uniform mat4 model;
 uniform mat4 view;
@@ -18,6 +19,9 @@ void main()
     // Use transpose(inverse(model)) to handle non-uniform scaling correctly
     Normal = normalize(mat3(transpose(inverse(model))) * normal);
     
+    // Per-particle fade is only used by splash_vertex.glsl
+    ParticleAlpha = 1.0;
+
     // Calculate final position
     gl_Position = projection * view * model * vec4(position, 1.0);
 }
\ No newline at end of file